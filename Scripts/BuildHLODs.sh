@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+# Headless HLOD build for a World Partition map, for Linux build machines without a GPU.
+#
+#   UE_ROOT=/opt/UnrealEngine Scripts/BuildHLODs.sh [/Game/FirstPerson/Maps/FirstPersonMap]
+#
+# Reports per-cell cost, makes sure the map has HLOD layers, builds the HLOD actors and reports again.
+# WorldPartitionHLODsBuilder only rebuilds HLOD actors whose source actors changed, so reruns are incremental;
+# pass -ForceBuild in EXTRA_ARGS to rebuild everything.
+#
+# Runs with -nullrhi by default, where the setup step switches every HLOD layer to instancing. HLOD_RENDERING=1 runs
+# with rendering and -AllowCommandletRendering on every step instead, so merged layers are kept (needs a GPU).
+set -euo pipefail
+
+PROJECT="$(cd "$(dirname "$0")/.." && pwd)/ThirdYearProject.uproject"
+MAP="${1:-/Game/FirstPerson/Maps/FirstPersonMap}"
+EDITOR="${UE_ROOT:?Set UE_ROOT to the engine directory}/Engine/Binaries/Linux/UnrealEditor-Cmd"
+if [[ "${HLOD_RENDERING:-0}" == 1 ]]; then
+    RENDER_ARGS=(-AllowCommandletRendering)
+else
+    RENDER_ARGS=(-nullrhi)
+fi
+ARGS=(-run=WorldPartitionBuilderCommandlet "${RENDER_ARGS[@]}" -unattended -nop4 -nosplash ${EXTRA_ARGS:-})
+
+"$EDITOR" "$PROJECT" "$MAP" "${ARGS[@]}" -Builder=TP_HLODReportBuilder -Label=before
+"$EDITOR" "$PROJECT" "$MAP" "${ARGS[@]}" -Builder=TP_HLODSetupBuilder
+# The HLODs builder refuses to run without -AllowCommandletRendering, so it always gets it, even under -nullrhi
+"$EDITOR" "$PROJECT" "$MAP" "${ARGS[@]}" -Builder=WorldPartitionHLODsBuilder -SetupHLODs -BuildHLODs -AllowCommandletRendering
+"$EDITOR" "$PROJECT" "$MAP" "${ARGS[@]}" -Builder=TP_HLODReportBuilder -Label=after
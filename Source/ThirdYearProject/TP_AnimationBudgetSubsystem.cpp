@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_AnimationBudgetSubsystem.h"
+#include "ThirdYearProject.h"
+#include "IAnimationBudgetAllocator.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTPAnimBudget);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budgeted Anim Meshes"), STAT_TPAnimMeshes, STATGROUP_ThirdYearProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Throttled Anim Meshes"), STAT_TPAnimThrottled, STATGROUP_ThirdYearProject);
+
+bool UTP_AnimationBudgetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTP_AnimationBudgetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// The delegate is static and shared by every world; the function looks up the component's own subsystem
+	if (!USkeletalMeshComponentBudgeted::OnCalculateSignificance().IsBound())
+	{
+		USkeletalMeshComponentBudgeted::OnCalculateSignificance().BindStatic(&UTP_AnimationBudgetSubsystem::CalculateSignificance);
+	}
+}
+
+void UTP_AnimationBudgetSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (IAnimationBudgetAllocator* Allocator = IAnimationBudgetAllocator::Get(&InWorld))
+	{
+		Allocator->SetEnabled(true);
+	}
+}
+
+void UTP_AnimationBudgetSubsystem::ConfigureComponent(USkeletalMeshComponentBudgeted* Component, const APawn* Pawn)
+{
+	if (Component == nullptr)
+	{
+		return;
+	}
+
+	TrackedComponents.AddUnique(Component);
+
+	if (Pawn != nullptr && Pawn->IsLocallyControlled() && Pawn->IsPlayerControlled())
+	{
+		// What the player sees in first person is never skipped or interpolated
+		Component->SetAutoCalculateSignificance(false);
+		Component->SetComponentSignificance(1.f, true, true, false, false);
+	}
+	else
+	{
+		Component->SetAutoCalculateSignificance(true);
+	}
+}
+
+float UTP_AnimationBudgetSubsystem::CalculateSignificance(USkeletalMeshComponentBudgeted* Component)
+{
+	const UWorld* World = Component->GetWorld();
+	const UTP_AnimationBudgetSubsystem* Subsystem = World ? World->GetSubsystem<UTP_AnimationBudgetSubsystem>() : nullptr;
+	if (Subsystem == nullptr || Subsystem->ViewLocations.Num() == 0)
+	{
+		return 1.f;
+	}
+
+	const FVector Location = Component->GetComponentLocation();
+	float ClosestDistanceSq = TNumericLimits<float>::Max();
+	for (const FVector& ViewLocation : Subsystem->ViewLocations)
+	{
+		ClosestDistanceSq = FMath::Min(ClosestDistanceSq, static_cast<float>(FVector::DistSquared(ViewLocation, Location)));
+	}
+
+	const float DistanceSignificance = 1.f - FMath::Clamp(FMath::Sqrt(ClosestDistanceSq) / Subsystem->MaxSignificanceDistance, 0.f, 1.f);
+	const float VisibilityScale = Component->WasRecentlyRendered(0.2f) ? 1.f : Subsystem->OffscreenSignificanceScale;
+	return DistanceSignificance * VisibilityScale;
+}
+
+void UTP_AnimationBudgetSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ViewLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController != nullptr && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+
+	// World tickables run after all tick groups, so this frame's animation work has already happened
+	NumMeshes = 0;
+	NumThrottled = 0;
+	for (int32 Index = TrackedComponents.Num() - 1; Index >= 0; --Index)
+	{
+		const USkeletalMeshComponentBudgeted* Component = TrackedComponents[Index].Get();
+		if (Component == nullptr)
+		{
+			TrackedComponents.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		if (Component->IsRegistered() && Component->GetSkeletalMeshAsset() != nullptr)
+		{
+			++NumMeshes;
+			NumThrottled += Component->PoseTickedThisFrame() ? 0 : 1;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_TPAnimMeshes, NumMeshes);
+	SET_DWORD_STAT(STAT_TPAnimThrottled, NumThrottled);
+}
+
+TStatId UTP_AnimationBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTP_AnimationBudgetSubsystem, STATGROUP_Tickables);
+}
+
+static FAutoConsoleCommandWithWorld GTPAnimBudgetStatsCommand(
+	TEXT("TP.AnimBudget.Stats"),
+	TEXT("Logs how many budgeted character meshes skipped their animation update last frame"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UTP_AnimationBudgetSubsystem* Subsystem = World->GetSubsystem<UTP_AnimationBudgetSubsystem>())
+		{
+			UE_LOG(LogTPAnimBudget, Display, TEXT("%d of %d budgeted meshes throttled"), Subsystem->GetNumThrottled(), Subsystem->GetNumMeshes());
+		}
+	}));
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TP_AnimationBudgetSubsystem.generated.h"
+
+class APawn;
+class USkeletalMeshComponentBudgeted;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPAnimBudget, Log, All);
+
+/**
+ * Drives the engine's animation budget allocator for character and weapon meshes.
+ *
+ * The local player's own meshes always tick at full rate. Everything else (bots, remote players) gets a significance
+ * from visibility and distance to the closest local view; the allocator then throttles the least significant meshes,
+ * interpolating between updates, to keep animation inside a.Budget.BudgetMs. Evaluation runs on worker threads through
+ * a.ParallelAnimUpdate / a.ParallelAnimEvaluation.
+ */
+UCLASS(config=Game)
+class THIRDYEARPROJECT_API UTP_AnimationBudgetSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Beyond this distance from every local view a mesh has no distance significance left */
+	UPROPERTY(config)
+	float MaxSignificanceDistance = 6000.f;
+
+	/** Significance multiplier for meshes that were not rendered recently */
+	UPROPERTY(config)
+	float OffscreenSignificanceScale = 0.2f;
+
+	/** Sets up a budgeted mesh owned by (or attached to) Pawn, call again when the pawn's controller changes */
+	void ConfigureComponent(USkeletalMeshComponentBudgeted* Component, const APawn* Pawn);
+
+	/** Meshes tracked last frame, and how many of them skipped their animation update */
+	int32 GetNumMeshes() const { return NumMeshes; }
+	int32 GetNumThrottled() const { return NumThrottled; }
+
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	// USubsystem implementation End
+
+	// UWorldSubsystem implementation Begin
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	// UWorldSubsystem implementation End
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// FTickableGameObject implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Bound to USkeletalMeshComponentBudgeted::OnCalculateSignificance */
+	static float CalculateSignificance(USkeletalMeshComponentBudgeted* Component);
+
+	/** View locations of all local players, refreshed every frame */
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+
+	TArray<TWeakObjectPtr<USkeletalMeshComponentBudgeted>> TrackedComponents;
+
+	int32 NumMeshes = 0;
+	int32 NumThrottled = 0;
+};
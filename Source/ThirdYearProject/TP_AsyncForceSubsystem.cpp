@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_AsyncForceSubsystem.h"
+#include "ThirdYearProjectProjectile.h"
+#include "Components/PrimitiveComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PhysicsEngine/BodyInstance.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+#include "PBDRigidsSolver.h"
+#include "EngineUtils.h"
+
+DEFINE_LOG_CATEGORY(LogTPAsyncForces);
+
+static TAutoConsoleVariable<int32> CVarTPAsyncForces(
+	TEXT("TP.AsyncForces"),
+	0,
+	TEXT("0: explosion impulses are applied on the game thread.\n")
+	TEXT("1: impulses are queued and applied inside a Chaos sim callback at the next physics step."),
+	ECVF_Default);
+
+void FTP_AsyncForceCallback::OnPreSimulate_Internal()
+{
+	const FTP_AsyncForceInput* Input = GetConsumerInput_Internal();
+	if (Input == nullptr)
+	{
+		return;
+	}
+
+	for (const FTP_AsyncImpulseCommand& Command : Input->Impulses)
+	{
+		Chaos::FRigidBodyHandle_Internal* Body = Command.Proxy->GetPhysicsThreadAPI();
+		if (Body == nullptr || (Body->ObjectState() != Chaos::EObjectStateType::Dynamic && Body->ObjectState() != Chaos::EObjectStateType::Sleeping))
+		{
+			continue;
+		}
+
+		const FVector DeltaVelocity = Command.bVelChange ? Command.Impulse : Command.Impulse * Body->InvM();
+		Body->SetV(Body->V() + DeltaVelocity);
+
+		// Same as AddImpulse on the game thread, a pushed body has to wake up
+		if (Body->ObjectState() == Chaos::EObjectStateType::Sleeping)
+		{
+			Body->SetObjectState(Chaos::EObjectStateType::Dynamic);
+		}
+	}
+}
+
+bool UTP_AsyncForceSubsystem::IsAsyncModeEnabled()
+{
+	return CVarTPAsyncForces.GetValueOnGameThread() != 0;
+}
+
+bool UTP_AsyncForceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTP_AsyncForceSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (FPhysScene* PhysScene = InWorld.GetPhysicsScene())
+	{
+		if (Chaos::FPBDRigidsSolver* Solver = PhysScene->GetSolver())
+		{
+			ForceCallback = Solver->CreateAndRegisterSimCallbackObject_External<FTP_AsyncForceCallback>();
+		}
+	}
+
+	if (IsAsyncModeEnabled() && !UPhysicsSettings::Get()->bTickPhysicsAsync)
+	{
+		UE_LOG(LogTPAsyncForces, Warning, TEXT("TP.AsyncForces is on but bTickPhysicsAsync is off, impulses will follow the frame-rate dependent physics step."));
+	}
+}
+
+void UTP_AsyncForceSubsystem::Deinitialize()
+{
+	if (ForceCallback != nullptr)
+	{
+		if (FPhysScene* PhysScene = GetWorld()->GetPhysicsScene())
+		{
+			if (Chaos::FPBDRigidsSolver* Solver = PhysScene->GetSolver())
+			{
+				Solver->UnregisterAndFreeSimCallbackObject_External(ForceCallback);
+			}
+		}
+		ForceCallback = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+void UTP_AsyncForceSubsystem::AddImpulse(UPrimitiveComponent* Component, const FVector& Impulse, bool bVelChange)
+{
+	FBodyInstance* BodyInstance = Component->GetBodyInstance();
+	Chaos::FSingleParticlePhysicsProxy* Proxy = BodyInstance != nullptr ? BodyInstance->GetPhysicsActorHandle() : nullptr;
+
+	if (!IsAsyncModeEnabled() || ForceCallback == nullptr || Proxy == nullptr)
+	{
+		Component->AddImpulse(Impulse, NAME_None, bVelChange);
+		return;
+	}
+
+	// The proxy is only released by the solver after inputs queued before the release have been consumed
+	ForceCallback->GetProducerInputData_External()->Impulses.Add({ Proxy, Impulse, bVelChange });
+	++NumAsyncImpulses;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPAsyncForcesBenchCommand(
+	TEXT("TP.AsyncForces.Bench"),
+	TEXT("Runs N explosions (default 500) on the simulated bodies in the level with TP.AsyncForces 0 and 1 and logs the game thread time of each."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumExplosions = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 500;
+
+		TArray<FVector> Origins;
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			It->ForEachComponent<UPrimitiveComponent>(false, [&Origins](const UPrimitiveComponent* Primitive)
+			{
+				if (Primitive->IsSimulatingPhysics())
+				{
+					Origins.Add(Primitive->GetComponentLocation() + FVector(0.f, 0.f, -50.f));
+				}
+			});
+		}
+
+		if (Origins.Num() == 0)
+		{
+			UE_LOG(LogTPAsyncForces, Warning, TEXT("No simulated bodies in %s, nothing to benchmark."), *World->GetName());
+			return;
+		}
+
+		// Measure the impulse path itself, not the line-of-sight traces in front of it
+		IConsoleVariable* OcclusionVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("TP.Explosion.Occlusion"));
+		const int32 PreviousOcclusion = OcclusionVariable ? OcclusionVariable->GetInt() : 0;
+		if (OcclusionVariable)
+		{
+			OcclusionVariable->Set(0, ECVF_SetByConsole);
+		}
+
+		const int32 PreviousMode = CVarTPAsyncForces.GetValueOnGameThread();
+		for (int32 Mode = 0; Mode <= 1; ++Mode)
+		{
+			CVarTPAsyncForces->Set(Mode, ECVF_SetByConsole);
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Index = 0; Index < NumExplosions; ++Index)
+			{
+				AThirdYearProjectProjectile::Explode(World, Origins[Index % Origins.Num()], nullptr);
+			}
+			const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+			UE_LOG(LogTPAsyncForces, Display, TEXT("TP.AsyncForces %d: %d explosions over %d bodies, %.3f ms game thread (%.4f ms per explosion)"),
+				Mode, NumExplosions, Origins.Num(), ElapsedMs, ElapsedMs / NumExplosions);
+		}
+		CVarTPAsyncForces->Set(PreviousMode, ECVF_SetByConsole);
+		if (OcclusionVariable)
+		{
+			OcclusionVariable->Set(PreviousOcclusion, ECVF_SetByConsole);
+		}
+	}));
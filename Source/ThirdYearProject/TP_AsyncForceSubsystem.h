@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Chaos/SimCallbackInput.h"
+#include "Chaos/SimCallbackObject.h"
+#include "TP_AsyncForceSubsystem.generated.h"
+
+class UPrimitiveComponent;
+
+namespace Chaos
+{
+	class FSingleParticlePhysicsProxy;
+}
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPAsyncForces, Log, All);
+
+/** One velocity change waiting to be applied on the physics thread */
+struct FTP_AsyncImpulseCommand
+{
+	Chaos::FSingleParticlePhysicsProxy* Proxy = nullptr;
+	FVector Impulse = FVector::ZeroVector;
+	bool bVelChange = true;
+};
+
+/** Everything the game thread queued for one physics step */
+struct FTP_AsyncForceInput : public Chaos::FSimCallbackInput
+{
+	TArray<FTP_AsyncImpulseCommand> Impulses;
+
+	void Reset()
+	{
+		Impulses.Reset();
+	}
+};
+
+/** Applies queued impulses at the start of every physics step */
+class FTP_AsyncForceCallback : public Chaos::TSimCallbackObject<FTP_AsyncForceInput>
+{
+	virtual void OnPreSimulate_Internal() override;
+};
+
+/**
+ * Routes explosion impulses on simulated bodies.
+ *
+ * With TP.AsyncForces 0 (default) everything is applied immediately on the game thread, as before.
+ * With TP.AsyncForces 1 impulses on simulated bodies are only enqueued on the game thread and applied inside a Chaos
+ * sim callback at the start of the next physics step. Combine with bTickPhysicsAsync=True in [/Script/Engine.PhysicsSettings]
+ * so that step runs at the fixed AsyncFixedTimeStepSize regardless of frame rate.
+ *
+ * Character launches and wall-run gravity stay on the game thread in both modes: the character movement component is not
+ * simulated by Chaos, so it consumes PendingLaunchVelocity and GravityScale in its own update either way.
+ */
+UCLASS()
+class THIRDYEARPROJECT_API UTP_AsyncForceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** True when impulses go through the physics thread callback */
+	static bool IsAsyncModeEnabled();
+
+	/** Adds an impulse to a simulated body, on the game thread or through the physics callback */
+	void AddImpulse(UPrimitiveComponent* Component, const FVector& Impulse, bool bVelChange);
+
+	/** Number of impulses sent through the physics callback since the world started */
+	int32 GetNumAsyncImpulses() const { return NumAsyncImpulses; }
+
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+	// USubsystem implementation End
+
+	// UWorldSubsystem implementation Begin
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	// UWorldSubsystem implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Owned by the solver, created on BeginPlay */
+	FTP_AsyncForceCallback* ForceCallback = nullptr;
+
+	int32 NumAsyncImpulses = 0;
+};
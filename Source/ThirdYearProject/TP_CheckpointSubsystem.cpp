@@ -0,0 +1,412 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_CheckpointSubsystem.h"
+#include "ThirdYearProjectCharacter.h"
+#include "ThirdYearProjectProjectile.h"
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "EngineUtils.h"
+
+DEFINE_LOG_CATEGORY(LogTPCheckpoint);
+
+namespace TPCheckpoint
+{
+	static constexpr uint32 FileMagic = 0x54504350; // 'TPCP'
+	static constexpr int32 FileVersion = 1;
+}
+
+FArchive& operator<<(FArchive& Ar, FTP_CharacterCheckpoint& Checkpoint)
+{
+	Ar << Checkpoint.CharacterName;
+	Ar << Checkpoint.Transform;
+	Ar << Checkpoint.ControlRotation;
+	Ar << Checkpoint.Velocity;
+	Ar << Checkpoint.MovementMode;
+	Ar << Checkpoint.GravityScale;
+	Ar << Checkpoint.MaxWalkSpeed;
+	Ar << Checkpoint.CapsuleHalfHeight;
+	Ar << Checkpoint.JumpCount;
+	Ar << Checkpoint.bIsSliding;
+	Ar << Checkpoint.SlideSpeed;
+	Ar << Checkpoint.SlideDirection;
+	Ar << Checkpoint.bIsWallRunning;
+	Ar << Checkpoint.WallRunDirection;
+	Ar << Checkpoint.WallRunNormal;
+	Ar << Checkpoint.bCanWallRun;
+	Ar << Checkpoint.WallRunCooldownRemaining;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FTP_ProjectileCheckpoint& Checkpoint)
+{
+	Ar << Checkpoint.Location;
+	Ar << Checkpoint.Rotation;
+	Ar << Checkpoint.Velocity;
+	Ar << Checkpoint.LifeSpanRemaining;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FTP_BodyCheckpoint& Checkpoint)
+{
+	Ar << Checkpoint.ComponentPath;
+	Ar << Checkpoint.Transform;
+	Ar << Checkpoint.LinearVelocity;
+	Ar << Checkpoint.AngularVelocity;
+	Ar << Checkpoint.bAwake;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FTP_CheckpointSnapshot& Snapshot)
+{
+	Ar << Snapshot.Characters;
+	Ar << Snapshot.Projectiles;
+	Ar << Snapshot.Bodies;
+	Ar << Snapshot.bValid;
+	return Ar;
+}
+
+bool UTP_CheckpointSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTP_CheckpointSubsystem::Deinitialize()
+{
+	Snapshots.Empty();
+	ParkedProjectiles.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTP_CheckpointSubsystem::IsValidSlot(int32 Slot) const
+{
+	if (Slot < 0 || Slot >= MaxSlots)
+	{
+		UE_LOG(LogTPCheckpoint, Warning, TEXT("Checkpoint slot %d is out of range, slots go from 0 to %d"), Slot, MaxSlots - 1);
+		return false;
+	}
+	return true;
+}
+
+void UTP_CheckpointSubsystem::CaptureCheckpoint(int32 Slot)
+{
+	if (!IsValidSlot(Slot))
+	{
+		return;
+	}
+
+	if (!Snapshots.IsValidIndex(Slot))
+	{
+		Snapshots.SetNum(Slot + 1);
+	}
+
+	// Reset keeps the allocations, so capturing into the same slot again doesn't allocate
+	FTP_CheckpointSnapshot& Snapshot = Snapshots[Slot];
+	Snapshot.Characters.Reset();
+	Snapshot.Projectiles.Reset();
+	Snapshot.Bodies.Reset();
+
+	UWorld* World = GetWorld();
+	for (TActorIterator<AThirdYearProjectCharacter> It(World); It; ++It)
+	{
+		It->SaveCheckpointState(Snapshot.Characters.AddDefaulted_GetRef());
+	}
+
+	for (TActorIterator<AThirdYearProjectProjectile> It(World); It; ++It)
+	{
+		if (It->IsParked())
+		{
+			continue;
+		}
+
+		FTP_ProjectileCheckpoint& Projectile = Snapshot.Projectiles.AddDefaulted_GetRef();
+		Projectile.Projectile = *It;
+		Projectile.Location = It->GetActorLocation();
+		Projectile.Rotation = It->GetActorRotation();
+		Projectile.Velocity = It->GetProjectileMovement()->Velocity;
+		Projectile.LifeSpanRemaining = It->GetLifeSpan();
+	}
+
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		It->ForEachComponent<UPrimitiveComponent>(false, [&Snapshot](UPrimitiveComponent* Primitive)
+		{
+			if (!Primitive->IsSimulatingPhysics())
+			{
+				return;
+			}
+
+			FTP_BodyCheckpoint& Body = Snapshot.Bodies.AddDefaulted_GetRef();
+			Body.Component = Primitive;
+			Body.ComponentPath = FSoftObjectPath(Primitive);
+			Body.Transform = Primitive->GetComponentTransform();
+			Body.LinearVelocity = Primitive->GetPhysicsLinearVelocity();
+			Body.AngularVelocity = Primitive->GetPhysicsAngularVelocityInDegrees();
+			Body.bAwake = Primitive->RigidBodyIsAwake();
+		});
+	}
+
+	Snapshot.bValid = true;
+	RefreshParkedProjectiles();
+
+	UE_LOG(LogTPCheckpoint, Log, TEXT("Checkpoint %d captured: %d characters, %d projectiles, %d bodies"), Slot, Snapshot.Characters.Num(), Snapshot.Projectiles.Num(), Snapshot.Bodies.Num());
+}
+
+bool UTP_CheckpointSubsystem::RestoreCheckpoint(int32 Slot)
+{
+	if (!Snapshots.IsValidIndex(Slot) || !Snapshots[Slot].bValid)
+	{
+		UE_LOG(LogTPCheckpoint, Warning, TEXT("Checkpoint %d is empty"), Slot);
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FTP_CheckpointSnapshot& Snapshot = Snapshots[Slot];
+	UWorld* World = GetWorld();
+
+	// Characters are matched by name; a lone character always matches so disk snapshots work across sessions
+	TArray<AThirdYearProjectCharacter*, TInlineAllocator<8>> Characters;
+	for (TActorIterator<AThirdYearProjectCharacter> It(World); It; ++It)
+	{
+		Characters.Add(*It);
+	}
+
+	for (const FTP_CharacterCheckpoint& Checkpoint : Snapshot.Characters)
+	{
+		AThirdYearProjectCharacter* const* Character = Characters.FindByPredicate([&Checkpoint](const AThirdYearProjectCharacter* Candidate)
+		{
+			return Candidate->GetFName() == Checkpoint.CharacterName;
+		});
+
+		if (Character != nullptr)
+		{
+			(*Character)->RestoreCheckpointState(Checkpoint);
+		}
+		else if (Characters.Num() == 1 && Snapshot.Characters.Num() == 1)
+		{
+			Characters[0]->RestoreCheckpointState(Checkpoint);
+		}
+	}
+
+	// Projectiles: the snapshot's own actors come back from being parked; entries without an actor (loaded from disk)
+	// borrow any other projectile, those still left over are retired
+	TArray<AThirdYearProjectProjectile*, TInlineAllocator<32>> Spare;
+	for (TActorIterator<AThirdYearProjectProjectile> It(World); It; ++It)
+	{
+		const bool bInSnapshot = Snapshot.Projectiles.ContainsByPredicate([Projectile = *It](const FTP_ProjectileCheckpoint& Checkpoint)
+		{
+			return Checkpoint.Projectile.Get() == Projectile;
+		});
+
+		if (!bInSnapshot)
+		{
+			Spare.Add(*It);
+		}
+	}
+
+	int32 NumMissingProjectiles = 0;
+	for (const FTP_ProjectileCheckpoint& Checkpoint : Snapshot.Projectiles)
+	{
+		AThirdYearProjectProjectile* Projectile = Checkpoint.Projectile.Get();
+		if (Projectile == nullptr && Spare.Num() > 0)
+		{
+			Projectile = Spare.Pop(false);
+		}
+
+		if (Projectile != nullptr)
+		{
+			Projectile->RestoreFlight(Checkpoint.Location, Checkpoint.Rotation, Checkpoint.Velocity, Checkpoint.LifeSpanRemaining);
+		}
+		else
+		{
+			++NumMissingProjectiles;
+		}
+	}
+
+	for (AThirdYearProjectProjectile* Projectile : Spare)
+	{
+		if (ShouldParkProjectile(Projectile))
+		{
+			Projectile->SetParked(true);
+		}
+		else
+		{
+			Projectile->Destroy();
+		}
+	}
+
+	for (const FTP_BodyCheckpoint& Body : Snapshot.Bodies)
+	{
+		UPrimitiveComponent* Primitive = Body.Component.Get();
+		if (Primitive == nullptr)
+		{
+			continue;
+		}
+
+		Primitive->SetWorldTransform(Body.Transform, false, nullptr, ETeleportType::TeleportPhysics);
+		Primitive->SetPhysicsLinearVelocity(Body.LinearVelocity);
+		Primitive->SetPhysicsAngularVelocityInDegrees(Body.AngularVelocity);
+		if (Body.bAwake)
+		{
+			Primitive->WakeRigidBody();
+		}
+		else
+		{
+			Primitive->PutRigidBodyToSleep();
+		}
+	}
+
+	LastRestoreMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	UE_LOG(LogTPCheckpoint, Log, TEXT("Checkpoint %d restored in %.3f ms"), Slot, LastRestoreMs);
+	if (NumMissingProjectiles > 0)
+	{
+		UE_LOG(LogTPCheckpoint, Warning, TEXT("Checkpoint %d: %d projectiles had no actor to restore into"), Slot, NumMissingProjectiles);
+	}
+
+	return true;
+}
+
+bool UTP_CheckpointSubsystem::ShouldParkProjectile(const AThirdYearProjectProjectile* Projectile) const
+{
+	return ParkedProjectiles.Contains(TWeakObjectPtr<AThirdYearProjectProjectile>(const_cast<AThirdYearProjectProjectile*>(Projectile)));
+}
+
+void UTP_CheckpointSubsystem::RefreshParkedProjectiles()
+{
+	ParkedProjectiles.Reset();
+	for (const FTP_CheckpointSnapshot& Snapshot : Snapshots)
+	{
+		for (const FTP_ProjectileCheckpoint& Checkpoint : Snapshot.Projectiles)
+		{
+			if (Checkpoint.Projectile.IsValid())
+			{
+				ParkedProjectiles.Add(Checkpoint.Projectile);
+			}
+		}
+	}
+}
+
+FString UTP_CheckpointSubsystem::GetCheckpointFilename(const FString& Name)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Checkpoints") / (Name + TEXT(".tpcp"));
+}
+
+bool UTP_CheckpointSubsystem::SaveCheckpointToFile(int32 Slot, const FString& Name)
+{
+	if (!Snapshots.IsValidIndex(Slot) || !Snapshots[Slot].bValid)
+	{
+		return false;
+	}
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = TPCheckpoint::FileMagic;
+	int32 Version = TPCheckpoint::FileVersion;
+	Writer << Magic;
+	Writer << Version;
+	Writer << Snapshots[Slot];
+
+	const FString Filename = GetCheckpointFilename(Name);
+	if (!FFileHelper::SaveArrayToFile(Bytes, *Filename))
+	{
+		UE_LOG(LogTPCheckpoint, Error, TEXT("Failed to write checkpoint %d to %s"), Slot, *Filename);
+		return false;
+	}
+
+	UE_LOG(LogTPCheckpoint, Log, TEXT("Checkpoint %d written to %s (%d bytes)"), Slot, *Filename, Bytes.Num());
+	return true;
+}
+
+bool UTP_CheckpointSubsystem::LoadCheckpointFromFile(int32 Slot, const FString& Name)
+{
+	if (!IsValidSlot(Slot))
+	{
+		return false;
+	}
+
+	const FString Filename = GetCheckpointFilename(Name);
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		UE_LOG(LogTPCheckpoint, Error, TEXT("Failed to read checkpoint %s"), *Filename);
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+	if (Magic != TPCheckpoint::FileMagic || Version != TPCheckpoint::FileVersion)
+	{
+		UE_LOG(LogTPCheckpoint, Error, TEXT("%s is not a checkpoint of version %d"), *Filename, TPCheckpoint::FileVersion);
+		return false;
+	}
+
+	if (!Snapshots.IsValidIndex(Slot))
+	{
+		Snapshots.SetNum(Slot + 1);
+	}
+
+	Reader << Snapshots[Slot];
+	if (Reader.IsError())
+	{
+		Snapshots[Slot] = FTP_CheckpointSnapshot();
+		return false;
+	}
+
+	ResolveSnapshot(Snapshots[Slot]);
+	RefreshParkedProjectiles();
+	return true;
+}
+
+void UTP_CheckpointSubsystem::ResolveSnapshot(FTP_CheckpointSnapshot& Snapshot)
+{
+	const bool bIsPIE = GetWorld()->WorldType == EWorldType::PIE;
+	for (FTP_BodyCheckpoint& Body : Snapshot.Bodies)
+	{
+		if (bIsPIE)
+		{
+			Body.ComponentPath.FixupForPIE();
+		}
+		Body.Component = Cast<UPrimitiveComponent>(Body.ComponentPath.ResolveObject());
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPCheckpointSaveCommand(
+	TEXT("TP.Checkpoint.Save"),
+	TEXT("Captures a checkpoint. Usage: TP.Checkpoint.Save [Slot] [FileName]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTP_CheckpointSubsystem* Checkpoints = World->GetSubsystem<UTP_CheckpointSubsystem>())
+		{
+			const int32 Slot = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 0;
+			Checkpoints->CaptureCheckpoint(Slot);
+			if (Args.Num() > 1)
+			{
+				Checkpoints->SaveCheckpointToFile(Slot, Args[1]);
+			}
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GTPCheckpointLoadCommand(
+	TEXT("TP.Checkpoint.Load"),
+	TEXT("Restores a checkpoint. Usage: TP.Checkpoint.Load [Slot] [FileName]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTP_CheckpointSubsystem* Checkpoints = World->GetSubsystem<UTP_CheckpointSubsystem>())
+		{
+			const int32 Slot = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 0;
+			if (Args.Num() > 1 && !Checkpoints->LoadCheckpointFromFile(Slot, Args[1]))
+			{
+				return;
+			}
+			Checkpoints->RestoreCheckpoint(Slot);
+		}
+	}));
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TP_CheckpointSubsystem.generated.h"
+
+class AThirdYearProjectCharacter;
+class AThirdYearProjectProjectile;
+class UPrimitiveComponent;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPCheckpoint, Log, All);
+
+/** Dynamic state of one AThirdYearProjectCharacter */
+struct FTP_CharacterCheckpoint
+{
+	FName CharacterName;
+	FTransform Transform;
+	FRotator ControlRotation;
+	FVector Velocity;
+	uint8 MovementMode = 0;
+	float GravityScale = 1.f;
+	float MaxWalkSpeed = 0.f;
+	float CapsuleHalfHeight = 0.f;
+	int32 JumpCount = 0;
+	bool bIsSliding = false;
+	float SlideSpeed = 0.f;
+	FVector SlideDirection;
+	bool bIsWallRunning = false;
+	FVector WallRunDirection;
+	FVector WallRunNormal;
+	bool bCanWallRun = true;
+	/** Time left on the wall-run cooldown timer, 0 if it isn't running */
+	float WallRunCooldownRemaining = 0.f;
+
+	friend FArchive& operator<<(FArchive& Ar, FTP_CharacterCheckpoint& Checkpoint);
+};
+
+/** A live projectile */
+struct FTP_ProjectileCheckpoint
+{
+	TWeakObjectPtr<AThirdYearProjectProjectile> Projectile;
+	FVector Location;
+	FRotator Rotation;
+	FVector Velocity;
+	float LifeSpanRemaining = 0.f;
+
+	friend FArchive& operator<<(FArchive& Ar, FTP_ProjectileCheckpoint& Checkpoint);
+};
+
+/** A simulated physics body, e.g. one pushed around by explosions */
+struct FTP_BodyCheckpoint
+{
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	/** Used to find the component again after loading from disk */
+	FSoftObjectPath ComponentPath;
+	FTransform Transform;
+	FVector LinearVelocity;
+	FVector AngularVelocity;
+	bool bAwake = false;
+
+	friend FArchive& operator<<(FArchive& Ar, FTP_BodyCheckpoint& Checkpoint);
+};
+
+/** Complete dynamic state of the level at one point in time */
+struct FTP_CheckpointSnapshot
+{
+	TArray<FTP_CharacterCheckpoint> Characters;
+	TArray<FTP_ProjectileCheckpoint> Projectiles;
+	TArray<FTP_BodyCheckpoint> Bodies;
+	bool bValid = false;
+
+	friend FArchive& operator<<(FArchive& Ar, FTP_CheckpointSnapshot& Snapshot);
+};
+
+/**
+ * Instant practice-mode restarts: captures characters, projectiles and simulated bodies into in-memory slots and
+ * writes them back in place, without reloading the map or respawning actors.
+ *
+ * Projectiles that are part of a snapshot are parked (hidden, no collision) instead of destroyed when they hit or
+ * expire, so they can be brought back on restore.
+ */
+UCLASS(config=Game)
+class THIRDYEARPROJECT_API UTP_CheckpointSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Slots are numbered 0 to MaxSlots - 1, anything else is rejected */
+	UPROPERTY(config)
+	int32 MaxSlots = 16;
+
+	/** Captures the current state into Slot */
+	UFUNCTION(BlueprintCallable, Category=Checkpoint)
+	void CaptureCheckpoint(int32 Slot);
+
+	/** Writes Slot back into the world, returns false if the slot is empty */
+	UFUNCTION(BlueprintCallable, Category=Checkpoint)
+	bool RestoreCheckpoint(int32 Slot);
+
+	/** Saves Slot to Saved/Checkpoints/<Name>.tpcp */
+	UFUNCTION(BlueprintCallable, Category=Checkpoint)
+	bool SaveCheckpointToFile(int32 Slot, const FString& Name);
+
+	/** Loads Saved/Checkpoints/<Name>.tpcp into Slot */
+	UFUNCTION(BlueprintCallable, Category=Checkpoint)
+	bool LoadCheckpointFromFile(int32 Slot, const FString& Name);
+
+	/** True if the projectile belongs to a snapshot and must be parked rather than destroyed */
+	bool ShouldParkProjectile(const AThirdYearProjectProjectile* Projectile) const;
+
+	/** Duration of the last restore, in milliseconds */
+	double GetLastRestoreMs() const { return LastRestoreMs; }
+
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+	// USubsystem implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	static FString GetCheckpointFilename(const FString& Name);
+
+	/** False (with a warning) for slots outside 0 to MaxSlots - 1, so a console typo can't allocate millions of slots */
+	bool IsValidSlot(int32 Slot) const;
+
+	/** Re-resolves weak pointers of a snapshot loaded from disk */
+	void ResolveSnapshot(FTP_CheckpointSnapshot& Snapshot);
+
+	/** Rebuilds ParkedProjectiles from all slots */
+	void RefreshParkedProjectiles();
+
+	TArray<FTP_CheckpointSnapshot> Snapshots;
+
+	/** Projectiles referenced by any snapshot */
+	TSet<TWeakObjectPtr<AThirdYearProjectProjectile>> ParkedProjectiles;
+
+	double LastRestoreMs = 0.0;
+};
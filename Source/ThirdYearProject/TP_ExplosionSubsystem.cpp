@@ -0,0 +1,215 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_ExplosionSubsystem.h"
+#include "ThirdYearProject.h"
+#include "TP_AsyncForceSubsystem.h"
+#include "TP_NavUpdateSubsystem.h"
+#include "TP_ReplaySubsystem.h"
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTPExplosion);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Explosion LOS Traces"), STAT_TPExplosionTraces, STATGROUP_ThirdYearProject);
+
+static TAutoConsoleVariable<int32> CVarTPExplosionOcclusion(
+	TEXT("TP.Explosion.Occlusion"),
+	0,
+	TEXT("0: explosions push everything in range immediately, through walls (default, as before).\n")
+	TEXT("1: explosions check line of sight with one batch of async traces and apply impulses when it returns."),
+	ECVF_Default);
+
+bool UTP_ExplosionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UTP_ExplosionSubsystem::IsOcclusionEnabled()
+{
+	return CVarTPExplosionOcclusion.GetValueOnGameThread() != 0;
+}
+
+void UTP_ExplosionSubsystem::Deinitialize()
+{
+	// Traces still in flight find no explosion and are dropped
+	PendingExplosions.Reset();
+
+	Super::Deinitialize();
+}
+
+void UTP_ExplosionSubsystem::Explode(const FVector& Origin, const AActor* IgnoredActor, float ForceScale)
+{
+	UWorld* World = GetWorld();
+
+	if (UTP_ReplaySubsystem* Replay = World->GetSubsystem<UTP_ReplaySubsystem>())
+	{
+		Replay->RecordExplosion(Origin);
+	}
+
+	// Find all bodies in the explosion radius
+	OverlapResults.Reset();
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TPExplosion), false, IgnoredActor);
+	World->OverlapMultiByChannel(OverlapResults, Origin, FQuat::Identity, ECC_PhysicsBody, FCollisionShape::MakeSphere(ExplosionRadius), QueryParams);
+
+	FPendingExplosion Explosion;
+	Explosion.Origin = Origin;
+	Explosion.ForceScale = ForceScale;
+	Explosion.Targets.Reserve(OverlapResults.Num());
+	for (const FOverlapResult& Result : OverlapResults)
+	{
+		if (UPrimitiveComponent* Component = Result.GetComponent())
+		{
+			Explosion.Targets.Add({ Component, static_cast<float>(FVector::DistSquared(Origin, Component->GetComponentLocation())), 1.f });
+		}
+	}
+
+	if (Explosion.Targets.Num() == 0)
+	{
+		return;
+	}
+
+	// Closest first: they take the most force, the budgets go to them. Bodies past MaxBodiesPerExplosion aren't pushed at all
+	Explosion.Targets.Sort([](const FTarget& A, const FTarget& B) { return A.DistanceSq < B.DistanceSq; });
+	const int32 NumBodies = FMath::Clamp(MaxBodiesPerExplosion, 0, Explosion.Targets.Num());
+	NumCapped += Explosion.Targets.Num() - NumBodies;
+	Explosion.Targets.SetNum(NumBodies, false);
+
+	if (!IsOcclusionEnabled())
+	{
+		for (const FTarget& Target : Explosion.Targets)
+		{
+			ApplyImpulse(Origin, Target.Component.Get(), 1.f, ForceScale);
+		}
+		return;
+	}
+
+	// Targets past the trace budget still move, just without a trace
+	const int32 NumTraced = FMath::Clamp(MaxTracesPerExplosion, 0, Explosion.Targets.Num());
+	for (int32 Index = NumTraced; Index < Explosion.Targets.Num(); ++Index)
+	{
+		Explosion.Targets[Index].ForceScale = OverBudgetForceScale;
+	}
+	NumOverBudget += Explosion.Targets.Num() - NumTraced;
+
+	if (NumTraced == 0)
+	{
+		for (const FTarget& Target : Explosion.Targets)
+		{
+			ApplyImpulse(Origin, Target.Component.Get(), Target.ForceScale, ForceScale);
+		}
+		return;
+	}
+
+	const uint32 ExplosionId = NextExplosionId++;
+	const FTraceDelegate TraceDelegate = FTraceDelegate::CreateUObject(this, &UTP_ExplosionSubsystem::OnLineOfSightTrace, ExplosionId);
+
+	// Static geometry only: other bodies and characters in the way are being pushed as well and give no cover, a player
+	// behind a bot or a crate inside a pile still gets the blast
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(TPExplosionLineOfSight), false, IgnoredActor);
+	const FCollisionObjectQueryParams CoverObjects(ECC_WorldStatic);
+	for (int32 Index = 0; Index < NumTraced; ++Index)
+	{
+		const FVector TargetLocation = Explosion.Targets[Index].Component->GetComponentLocation();
+		World->AsyncLineTraceByObjectType(EAsyncTraceType::Single, Origin, TargetLocation, CoverObjects, TraceParams, &TraceDelegate, Index);
+	}
+
+	Explosion.TracesInFlight = NumTraced;
+	NumTraces += NumTraced;
+	INC_DWORD_STAT_BY(STAT_TPExplosionTraces, NumTraced);
+
+	PendingExplosions.Add(ExplosionId, MoveTemp(Explosion));
+}
+
+void UTP_ExplosionSubsystem::OnLineOfSightTrace(const FTraceHandle& Handle, FTraceDatum& Datum, uint32 ExplosionId)
+{
+	FPendingExplosion* Explosion = PendingExplosions.Find(ExplosionId);
+	if (Explosion == nullptr || !Explosion->Targets.IsValidIndex(Datum.UserData))
+	{
+		return;
+	}
+
+	// The trace only sees static geometry, so anything it hits other than the target itself is cover
+	FTarget& Target = Explosion->Targets[Datum.UserData];
+	const UPrimitiveComponent* TargetComponent = Target.Component.Get();
+	for (const FHitResult& Hit : Datum.OutHits)
+	{
+		if (Hit.bBlockingHit && Hit.GetComponent() != TargetComponent && (TargetComponent == nullptr || Hit.GetActor() != TargetComponent->GetOwner()))
+		{
+			Target.ForceScale = OccludedForceScale;
+			++NumOccluded;
+			break;
+		}
+	}
+
+	if (--Explosion->TracesInFlight > 0)
+	{
+		return;
+	}
+
+	// The whole batch is in, push everything at once
+	for (const FTarget& Result : Explosion->Targets)
+	{
+		if (Result.ForceScale > 0.f)
+		{
+			ApplyImpulse(Explosion->Origin, Result.Component.Get(), Result.ForceScale, Explosion->ForceScale);
+		}
+	}
+	PendingExplosions.Remove(ExplosionId);
+}
+
+void UTP_ExplosionSubsystem::ApplyImpulse(const FVector& Origin, UPrimitiveComponent* Component, float CoverScale, float BodyForceScale) const
+{
+	if (Component == nullptr)
+	{
+		return;
+	}
+
+	FVector Direction = Component->GetComponentLocation() - Origin;
+	const float Distance = Direction.Size();
+	Direction.Normalize();
+
+	// Scale force based on distance
+	const float ScaledForce = ExplosionForce * FMath::Max(1.f - Distance / ExplosionRadius, 0.f) * CoverScale;
+
+	// Apply force to physics objects, through the physics thread when async force mode is on
+	// Separate impulses on a body add up, so merged pellets push it as hard as all of them together would
+	if (Component->IsSimulatingPhysics())
+	{
+		const float BodyForce = ScaledForce * BodyForceScale;
+		if (UTP_AsyncForceSubsystem* ForceSubsystem = GetWorld()->GetSubsystem<UTP_AsyncForceSubsystem>())
+		{
+			ForceSubsystem->AddImpulse(Component, Direction * BodyForce, true);
+		}
+		else
+		{
+			Component->AddImpulse(Direction * BodyForce, NAME_None, true);
+		}
+
+		// Bodies that get knocked around leave the navmesh until they settle
+		if (UTP_NavUpdateSubsystem* NavUpdateSubsystem = GetWorld()->GetSubsystem<UTP_NavUpdateSubsystem>())
+		{
+			NavUpdateSubsystem->NotifyDisplaced(Component, BodyForce);
+		}
+	}
+
+	// Apply force to characters; a launch overrides velocity, so separate pellets would only ever launch at one
+	// blast's strength and merged ones don't scale it either
+	if (ACharacter* AffectedCharacter = Cast<ACharacter>(Component->GetOwner()))
+	{
+		AffectedCharacter->LaunchCharacter(Direction * ScaledForce, true, true);
+	}
+}
+
+static FAutoConsoleCommandWithWorld GTPExplosionStatsCommand(
+	TEXT("TP.Explosion.Stats"),
+	TEXT("Logs explosion line-of-sight traces, occluded targets, targets pushed untraced for budget and bodies left out over the cap"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UTP_ExplosionSubsystem* Subsystem = World->GetSubsystem<UTP_ExplosionSubsystem>())
+		{
+			UE_LOG(LogTPExplosion, Display, TEXT("%d line-of-sight traces, %d targets behind cover, %d targets pushed untraced over budget, %d bodies over the cap"),
+				Subsystem->GetNumTraces(), Subsystem->GetNumOccluded(), Subsystem->GetNumOverBudget(), Subsystem->GetNumCapped());
+		}
+	}));
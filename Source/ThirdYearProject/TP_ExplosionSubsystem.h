@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "TP_ExplosionSubsystem.generated.h"
+
+class UPrimitiveComponent;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPExplosion, Log, All);
+
+/**
+ * Resolves explosions: finds what is in range and pushes simulated bodies and characters away from the origin.
+ *
+ * With TP.Explosion.Occlusion 1 every target's line of sight to the origin is checked first. All checks for one
+ * explosion go out together as async traces against static geometry, which run on worker threads during the frame.
+ * The impulses are applied when the last one comes back, next frame. Targets behind walls only get OccludedForceScale
+ * of the force; other bodies and characters never count as cover. Only the closest MaxTracesPerExplosion targets are
+ * traced, so a big physics pile costs the same as a small one; the rest are pushed untraced with OverBudgetForceScale in
+ * the same batch. With TP.Explosion.Occlusion 0 (default) impulses go straight through walls, immediately, as they
+ * always have. Either way only the closest MaxBodiesPerExplosion bodies are pushed at all.
+ */
+UCLASS(config=Game)
+class THIRDYEARPROJECT_API UTP_ExplosionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(config)
+	float ExplosionRadius = 500.f;
+
+	/** Velocity change at the origin, falling off linearly to nothing at ExplosionRadius */
+	UPROPERTY(config)
+	float ExplosionForce = 2000.f;
+
+	/** Bodies and characters pushed per explosion, closest first; the frame budget lowers this under load */
+	UPROPERTY(config)
+	int32 MaxBodiesPerExplosion = 64;
+
+	/** Line-of-sight traces per explosion, closest targets first */
+	UPROPERTY(config)
+	int32 MaxTracesPerExplosion = 24;
+
+	/** Force multiplier for targets without line of sight to the origin */
+	UPROPERTY(config)
+	float OccludedForceScale = 0.f;
+
+	/** Force multiplier for targets past MaxTracesPerExplosion, pushed without a line-of-sight check */
+	UPROPERTY(config)
+	float OverBudgetForceScale = 1.f;
+
+	/** True when explosions wait for line-of-sight traces */
+	static bool IsOcclusionEnabled();
+
+	/**
+	 * Pushes every body and character around Origin. ForceScale multiplies ExplosionForce for simulated bodies, whose
+	 * impulses add up (several pellets in one spot); characters are launched, which replaces their velocity, so they
+	 * always get a single blast's strength
+	 */
+	void Explode(const FVector& Origin, const AActor* IgnoredActor, float ForceScale = 1.f);
+
+	/**
+	 * Line-of-sight traces issued, targets found behind cover, targets pushed untraced for budget and bodies not pushed
+	 * because of MaxBodiesPerExplosion since the world started
+	 */
+	int32 GetNumTraces() const { return NumTraces; }
+	int32 GetNumOccluded() const { return NumOccluded; }
+	int32 GetNumOverBudget() const { return NumOverBudget; }
+	int32 GetNumCapped() const { return NumCapped; }
+
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+	// USubsystem implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FTarget
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		float DistanceSq = 0.f;
+		float ForceScale = 1.f;
+	};
+
+	struct FPendingExplosion
+	{
+		FVector Origin = FVector::ZeroVector;
+		float ForceScale = 1.f;
+		TArray<FTarget> Targets;
+		int32 TracesInFlight = 0;
+	};
+
+	/** Applies the falloff force to one target, CoverScale is the cover multiplier and BodyForceScale only scales simulated bodies */
+	void ApplyImpulse(const FVector& Origin, UPrimitiveComponent* Component, float CoverScale, float BodyForceScale) const;
+
+	/** Async trace callback, UserData is the target index */
+	void OnLineOfSightTrace(const FTraceHandle& Handle, FTraceDatum& Datum, uint32 ExplosionId);
+
+	TMap<uint32, FPendingExplosion> PendingExplosions;
+	uint32 NextExplosionId = 0;
+
+	/** Reused by Explode */
+	TArray<FOverlapResult> OverlapResults;
+
+	int32 NumTraces = 0;
+	int32 NumOccluded = 0;
+	int32 NumOverBudget = 0;
+	int32 NumCapped = 0;
+};
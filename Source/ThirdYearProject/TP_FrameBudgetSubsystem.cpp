@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_FrameBudgetSubsystem.h"
+#include "ThirdYearProject.h"
+#include "ThirdYearProjectCharacter.h"
+#include "ThirdYearProjectProjectile.h"
+#include "TP_ExplosionSubsystem.h"
+#include "TP_SceneQuerySubsystem.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTPFrameBudget);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frame Budget Level"), STAT_TPFrameBudgetLevel, STATGROUP_ThirdYearProject);
+
+static TAutoConsoleVariable<int32> CVarTPBudgetEnable(
+	TEXT("TP.Budget.Enable"),
+	1,
+	TEXT("0: the frame budget governor keeps its current level (TP.Budget.SetLevel still works).\n")
+	TEXT("1: levels follow the game thread time."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarTPBudgetTargetMs(
+	TEXT("TP.Budget.TargetMs"),
+	14.f,
+	TEXT("Game thread milliseconds the frame budget governor scales gameplay work to stay under."),
+	ECVF_Default);
+
+namespace TPFrameBudget
+{
+	/** Projectiles over the cap retired per frame */
+	constexpr int32 MaxRetiresPerFrame = 8;
+
+	/** Lifespan given to retired projectiles, they go through the normal expiry (and checkpoint parking) next frame */
+	constexpr float RetireLifeSpan = 0.01f;
+}
+
+bool UTP_FrameBudgetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTP_FrameBudgetSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	NumLevels = FMath::Max(NumLevels, 1);
+	LiveProjectiles.Reserve(MaxLiveProjectiles);
+
+	// Cheapest to lose first: animation is interpolated and wall probes are a few frames stale before bots think less
+	// often, and gameplay-visible limits (explosion reach, projectiles) go last
+	if (IConsoleVariable* AnimBudgetMs = IConsoleManager::Get().FindConsoleVariable(TEXT("a.Budget.BudgetMs")))
+	{
+		// The console variable is process-wide and this knob lowers it, so its full value is the one seen before any world touched it
+		static const float FullAnimBudgetMs = AnimBudgetMs->GetFloat();
+		RegisterKnob(TEXT("AnimBudgetMs"), FullAnimBudgetMs, FullAnimBudgetMs * 0.33f, 1, [AnimBudgetMs](float Value)
+		{
+			AnimBudgetMs->Set(Value, ECVF_SetByCode);
+		});
+	}
+
+	if (UTP_SceneQuerySubsystem* SceneQueries = InWorld.GetSubsystem<UTP_SceneQuerySubsystem>())
+	{
+		RegisterKnob(TEXT("WallProbeInterval"), 1.f, 4.f, 1, [SceneQueries](float Value)
+		{
+			SceneQueries->SetProbeInterval(FMath::RoundToInt32(Value));
+		});
+	}
+
+	RegisterKnob(TEXT("BotTickInterval"), 0.f, 0.1f, 2, [this](float Value)
+	{
+		BotTickInterval = Value;
+		for (TActorIterator<AThirdYearProjectCharacter> It(GetWorld()); It; ++It)
+		{
+			ConfigureCharacter(*It);
+		}
+	});
+
+	if (UTP_ExplosionSubsystem* Explosions = InWorld.GetSubsystem<UTP_ExplosionSubsystem>())
+	{
+		RegisterKnob(TEXT("ExplosionMaxBodies"), Explosions->MaxBodiesPerExplosion, FMath::Min(Explosions->MaxBodiesPerExplosion, 6), 3, [Explosions](float Value)
+		{
+			Explosions->MaxBodiesPerExplosion = FMath::RoundToInt32(Value);
+		});
+	}
+
+	RegisterKnob(TEXT("MaxLiveProjectiles"), MaxLiveProjectiles, FMath::Min(MaxLiveProjectiles, 32), 3, [this](float Value)
+	{
+		ProjectileCap = FMath::RoundToInt32(Value);
+	});
+}
+
+void UTP_FrameBudgetSubsystem::Deinitialize()
+{
+	// Knobs can reach past this world (console variables), leave them all at full quality
+	for (FKnob& Knob : Knobs)
+	{
+		if (Knob.Value != Knob.FullValue)
+		{
+			Knob.Value = Knob.FullValue;
+			Knob.Apply(Knob.Value);
+		}
+	}
+	Knobs.Reset();
+
+	Super::Deinitialize();
+}
+
+void UTP_FrameBudgetSubsystem::RegisterKnob(FName Name, float FullValue, float ReducedValue, int32 FirstLevel, TFunction<void(float)> Apply)
+{
+	FKnob& Knob = Knobs.AddDefaulted_GetRef();
+	Knob.Name = Name;
+	Knob.FullValue = FullValue;
+	Knob.ReducedValue = ReducedValue;
+	Knob.FirstLevel = FMath::Clamp(FirstLevel, 1, NumLevels);
+	Knob.Apply = MoveTemp(Apply);
+	Knob.Value = GetKnobValue(Knob);
+	Knob.Apply(Knob.Value);
+}
+
+float UTP_FrameBudgetSubsystem::GetKnobValue(const FKnob& Knob) const
+{
+	if (Level < Knob.FirstLevel)
+	{
+		return Knob.FullValue;
+	}
+
+	const float Alpha = static_cast<float>(Level - Knob.FirstLevel + 1) / (NumLevels - Knob.FirstLevel + 1);
+	return FMath::Lerp(Knob.FullValue, Knob.ReducedValue, Alpha);
+}
+
+void UTP_FrameBudgetSubsystem::ConfigureCharacter(AThirdYearProjectCharacter* Character) const
+{
+	// Only bots think less often, human players (local or remote) always tick every frame
+	if (Character != nullptr)
+	{
+		Character->SetActorTickInterval(Character->IsPlayerControlled() ? 0.f : BotTickInterval);
+	}
+}
+
+void UTP_FrameBudgetSubsystem::TrackProjectile(AThirdYearProjectProjectile* Projectile)
+{
+	if (Projectile != nullptr)
+	{
+		LiveProjectiles.Add(Projectile);
+	}
+}
+
+void UTP_FrameBudgetSubsystem::SetLevel(int32 NewLevel, const TCHAR* Reason)
+{
+	NewLevel = FMath::Clamp(NewLevel, 0, NumLevels);
+	OverBudgetTime = 0.f;
+	UnderBudgetTime = 0.f;
+	if (NewLevel == Level)
+	{
+		return;
+	}
+
+	const int32 OldLevel = Level;
+	Level = NewLevel;
+
+	TStringBuilder<256> Changes;
+	for (FKnob& Knob : Knobs)
+	{
+		const float Value = GetKnobValue(Knob);
+		if (Value != Knob.Value)
+		{
+			Changes.Appendf(TEXT(" %s %g->%g"), *Knob.Name.ToString(), Knob.Value, Value);
+			Knob.Value = Value;
+			Knob.Apply(Value);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_TPFrameBudgetLevel, Level);
+	UE_LOG(LogTPFrameBudget, Log, TEXT("Level %d -> %d (%s, game thread %.2f ms, target %.2f ms):%s"),
+		OldLevel, Level, Reason, SmoothedMs, CVarTPBudgetTargetMs.GetValueOnGameThread(), Changes.Len() > 0 ? Changes.ToString() : TEXT(" no change"));
+}
+
+void UTP_FrameBudgetSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// GGameThreadTime is last frame's game thread work without waits
+	const double FrameMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	SmoothedMs = SmoothedMs > 0.0 ? FMath::Lerp(SmoothedMs, FrameMs, static_cast<double>(Smoothing)) : FrameMs;
+
+	RetireExcessProjectiles();
+
+	if (CVarTPBudgetEnable.GetValueOnGameThread() == 0)
+	{
+		return;
+	}
+
+	const float TargetMs = CVarTPBudgetTargetMs.GetValueOnGameThread();
+	if (SmoothedMs > TargetMs)
+	{
+		OverBudgetTime += DeltaTime;
+		UnderBudgetTime = 0.f;
+	}
+	else if (SmoothedMs < TargetMs * RecoverFraction)
+	{
+		UnderBudgetTime += DeltaTime;
+		OverBudgetTime = 0.f;
+	}
+	else
+	{
+		OverBudgetTime = 0.f;
+		UnderBudgetTime = 0.f;
+	}
+
+	if (OverBudgetTime >= ScaleDownDelay && Level < NumLevels)
+	{
+		SetLevel(Level + 1, TEXT("over budget"));
+	}
+	else if (UnderBudgetTime >= ScaleUpDelay && Level > 0)
+	{
+		SetLevel(Level - 1, TEXT("headroom"));
+	}
+}
+
+TStatId UTP_FrameBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTP_FrameBudgetSubsystem, STATGROUP_Tickables);
+}
+
+void UTP_FrameBudgetSubsystem::RetireExcessProjectiles()
+{
+	// Parked projectiles are out of play already and don't count
+	LiveProjectiles.RemoveAll([](const TWeakObjectPtr<AThirdYearProjectProjectile>& Projectile) { return !Projectile.IsValid() || Projectile->IsParked(); });
+
+	const int32 NumToRetire = FMath::Min(LiveProjectiles.Num() - ProjectileCap, TPFrameBudget::MaxRetiresPerFrame);
+	if (NumToRetire <= 0)
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < NumToRetire; ++Index)
+	{
+		LiveProjectiles[Index]->SetLifeSpan(TPFrameBudget::RetireLifeSpan);
+	}
+	LiveProjectiles.RemoveAt(0, NumToRetire, false);
+}
+
+void UTP_FrameBudgetSubsystem::LogStatus() const
+{
+	UE_LOG(LogTPFrameBudget, Display, TEXT("Level %d of %d, game thread %.2f ms (target %.2f ms), %s, %d live projectiles"),
+		Level, NumLevels, SmoothedMs, CVarTPBudgetTargetMs.GetValueOnGameThread(),
+		CVarTPBudgetEnable.GetValueOnGameThread() != 0 ? TEXT("automatic") : TEXT("fixed"), LiveProjectiles.Num());
+	for (const FKnob& Knob : Knobs)
+	{
+		UE_LOG(LogTPFrameBudget, Display, TEXT("  %s = %g (full %g, reduced %g from level %d)"),
+			*Knob.Name.ToString(), Knob.Value, Knob.FullValue, Knob.ReducedValue, Knob.FirstLevel);
+	}
+}
+
+static FAutoConsoleCommandWithWorld GTPBudgetStatusCommand(
+	TEXT("TP.Budget.Status"),
+	TEXT("Logs the frame budget level, game thread time and every knob"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UTP_FrameBudgetSubsystem* FrameBudget = World->GetSubsystem<UTP_FrameBudgetSubsystem>())
+		{
+			FrameBudget->LogStatus();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GTPBudgetSetLevelCommand(
+	TEXT("TP.Budget.SetLevel"),
+	TEXT("Sets the frame budget level, 0 is full quality. Use with TP.Budget.Enable 0 to hold it. Usage: TP.Budget.SetLevel <Level>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UTP_FrameBudgetSubsystem* FrameBudget = World->GetSubsystem<UTP_FrameBudgetSubsystem>();
+		if (FrameBudget != nullptr && Args.Num() > 0)
+		{
+			FrameBudget->SetLevel(FCString::Atoi(*Args[0]), TEXT("console"));
+		}
+	}));
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TP_FrameBudgetSubsystem.generated.h"
+
+class AThirdYearProjectCharacter;
+class AThirdYearProjectProjectile;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPFrameBudget, Log, All);
+
+/**
+ * Keeps the game thread inside TP.Budget.TargetMs by scaling gameplay work down under load and back up once it passes.
+ *
+ * Load is a smoothed game thread time. Above the target for ScaleDownDelay seconds the governor goes one level down,
+ * below RecoverFraction of the target for ScaleUpDelay seconds it goes one level up; the band in between changes nothing
+ * and every change restarts both timers, so it never oscillates between two levels frame to frame.
+ *
+ * Each registered knob has a full value (level 0) and a reduced value (last level) and starts scaling at its own level,
+ * so the cheapest-to-lose work goes first. Built in: animation budget, wall-run probe frequency, bot tick interval,
+ * explosion bodies per blast and live projectiles. Values are applied once per level change, and projectiles over a
+ * lowered cap are retired a few per frame, so a change never hitches.
+ */
+UCLASS(config=Game)
+class THIRDYEARPROJECT_API UTP_FrameBudgetSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Reduction levels past full quality */
+	UPROPERTY(config)
+	int32 NumLevels = 4;
+
+	/** Below this fraction of the target counts as headroom */
+	UPROPERTY(config)
+	float RecoverFraction = 0.75f;
+
+	/** Seconds over budget before scaling down, and under before scaling back up */
+	UPROPERTY(config)
+	float ScaleDownDelay = 0.25f;
+
+	UPROPERTY(config)
+	float ScaleUpDelay = 2.f;
+
+	/** Weight of the newest frame in the smoothed game thread time */
+	UPROPERTY(config)
+	float Smoothing = 0.1f;
+
+	/** Live projectiles at full quality */
+	UPROPERTY(config)
+	int32 MaxLiveProjectiles = 256;
+
+	/**
+	 * Adds a knob. Apply gets the knob's value whenever the level changes (and once now): FullValue up to FirstLevel,
+	 * then interpolated to ReducedValue at the last level.
+	 */
+	void RegisterKnob(FName Name, float FullValue, float ReducedValue, int32 FirstLevel, TFunction<void(float)> Apply);
+
+	/** Applies the current bot tick interval, call when the character's controller changes */
+	void ConfigureCharacter(AThirdYearProjectCharacter* Character) const;
+
+	/** Counts Projectile against the live projectile cap, the oldest ones are retired when it is exceeded */
+	void TrackProjectile(AThirdYearProjectProjectile* Projectile);
+
+	int32 GetLevel() const { return Level; }
+
+	/** Jumps straight to NewLevel */
+	void SetLevel(int32 NewLevel, const TCHAR* Reason);
+
+	/** Logs the level, load and every knob */
+	void LogStatus() const;
+
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+	// USubsystem implementation End
+
+	// UWorldSubsystem implementation Begin
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	// UWorldSubsystem implementation End
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// FTickableGameObject implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FKnob
+	{
+		FName Name;
+		float FullValue = 0.f;
+		float ReducedValue = 0.f;
+		int32 FirstLevel = 1;
+		float Value = 0.f;
+		TFunction<void(float)> Apply;
+	};
+
+	float GetKnobValue(const FKnob& Knob) const;
+	void RetireExcessProjectiles();
+
+	TArray<FKnob> Knobs;
+
+	int32 Level = 0;
+	double SmoothedMs = 0.0;
+	float OverBudgetTime = 0.f;
+	float UnderBudgetTime = 0.f;
+
+	/** Current values of the knobs applied per actor */
+	float BotTickInterval = 0.f;
+	int32 ProjectileCap = MAX_int32;
+
+	/** Oldest first */
+	TArray<TWeakObjectPtr<AThirdYearProjectProjectile>> LiveProjectiles;
+};
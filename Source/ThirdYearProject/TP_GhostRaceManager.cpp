@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_GhostRaceManager.h"
+#include "ThirdYearProjectCharacter.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/ConstructorHelpers.h"
+#include "EngineUtils.h"
+
+ATP_GhostRaceManager::ATP_GhostRaceManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	GhostInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("GhostInstances"));
+	GhostInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	GhostInstances->SetCanEverAffectNavigation(false);
+	GhostInstances->CastShadow = false;
+	GhostInstances->SetMobility(EComponentMobility::Movable);
+	// Custom data 0 is the ghost's movement state so the material can tint slides and wall-runs
+	GhostInstances->NumCustomDataFloats = 1;
+	RootComponent = GhostInstances;
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> GhostMeshFinder(TEXT("/Engine/BasicShapes/Cylinder"));
+	if (GhostMeshFinder.Succeeded())
+	{
+		GhostInstances->SetStaticMesh(GhostMeshFinder.Object);
+	}
+}
+
+int32 ATP_GhostRaceManager::AddGhost(const FTP_GhostRecording& Recording, float StartDelay)
+{
+	FGhost Ghost;
+	if (!Recording.Decode(Ghost.Samples) || Ghost.Samples.Num() == 0)
+	{
+		UE_LOG(LogTPGhost, Warning, TEXT("Ghost recording is empty or corrupt, not added"));
+		return INDEX_NONE;
+	}
+
+	Ghost.SampleInterval = 1.f / FMath::Max<uint16>(Recording.SampleRate, 1);
+	Ghost.StartDelay = StartDelay;
+
+	const FTP_GhostSample& First = Ghost.Samples[0];
+	GhostInstances->AddInstance(FTransform(FRotator(0.f, First.Yaw, 0.f), FVector(First.Location), GhostScale), true);
+
+	InstanceTransforms.SetNum(Ghosts.Num() + 1);
+	return Ghosts.Add(MoveTemp(Ghost));
+}
+
+void ATP_GhostRaceManager::ClearGhosts()
+{
+	Ghosts.Reset();
+	InstanceTransforms.Reset();
+	GhostInstances->ClearInstances();
+}
+
+void ATP_GhostRaceManager::RestartRace()
+{
+	RaceTime = 0.f;
+}
+
+void ATP_GhostRaceManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Ghosts.Num() == 0)
+	{
+		return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	RaceTime += DeltaTime;
+
+	for (int32 GhostIndex = 0; GhostIndex < Ghosts.Num(); ++GhostIndex)
+	{
+		FGhost& Ghost = Ghosts[GhostIndex];
+
+		// Ghosts that haven't started yet wait on their first sample, finished ones stay on their last
+		const float SampleTime = FMath::Max(RaceTime - Ghost.StartDelay, 0.f) / Ghost.SampleInterval;
+		const int32 Index = FMath::Min(FMath::FloorToInt32(SampleTime), Ghost.Samples.Num() - 1);
+		const int32 NextIndex = FMath::Min(Index + 1, Ghost.Samples.Num() - 1);
+		const float Alpha = FMath::Clamp(SampleTime - Index, 0.f, 1.f);
+
+		const FTP_GhostSample& From = Ghost.Samples[Index];
+		const FTP_GhostSample& To = Ghost.Samples[NextIndex];
+
+		const FVector Location = FMath::Lerp(FVector(From.Location), FVector(To.Location), Alpha);
+		const float Yaw = From.Yaw + FRotator::NormalizeAxis(To.Yaw - From.Yaw) * Alpha;
+
+		// Sliding ghosts are squashed to the lowered slide capsule
+		FVector Scale = GhostScale;
+		if (From.State & TPGhostState::Sliding)
+		{
+			Scale.Z *= 0.5f;
+		}
+
+		InstanceTransforms[GhostIndex] = FTransform(FRotator(0.f, Yaw, 0.f), Location, Scale);
+
+		if (From.State != Ghost.LastState)
+		{
+			Ghost.LastState = From.State;
+			GhostInstances->SetCustomDataValue(GhostIndex, 0, From.State, false);
+		}
+	}
+
+	GhostInstances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+
+	LastUpdateMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPGhostRecordCommand(
+	TEXT("TP.Ghost.Record"),
+	TEXT("Starts recording the local player's run, or stops and saves it. Usage: TP.Ghost.Record <Name>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PlayerController = World->GetFirstPlayerController();
+		AThirdYearProjectCharacter* Character = PlayerController ? Cast<AThirdYearProjectCharacter>(PlayerController->GetPawn()) : nullptr;
+		UTP_GhostRecorderComponent* Recorder = Character ? Character->GetGhostRecorder() : nullptr;
+		if (Recorder == nullptr)
+		{
+			return;
+		}
+
+		if (!Recorder->IsRecording())
+		{
+			Recorder->StartRecording();
+			return;
+		}
+
+		Recorder->StopRecording();
+		const FString Name = Args.Num() > 0 ? Args[0] : TEXT("Ghost");
+		if (!Recorder->SaveRecording(Name))
+		{
+			UE_LOG(LogTPGhost, Error, TEXT("Failed to save ghost %s"), *Name);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GTPGhostRaceCommand(
+	TEXT("TP.Ghost.Race"),
+	TEXT("Races saved ghosts. Usage: TP.Ghost.Race <Name> [Count=1] [StaggerSeconds=0.25]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		FTP_GhostRecording Recording;
+		if (Args.Num() == 0 || !Recording.LoadFromFile(Args[0]))
+		{
+			UE_LOG(LogTPGhost, Error, TEXT("No ghost to race"));
+			return;
+		}
+
+		const int32 Count = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1;
+		const float Stagger = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 0.25f;
+
+		ATP_GhostRaceManager* Manager = nullptr;
+		for (TActorIterator<ATP_GhostRaceManager> It(World); It; ++It)
+		{
+			Manager = *It;
+			break;
+		}
+		if (Manager == nullptr)
+		{
+			Manager = World->SpawnActor<ATP_GhostRaceManager>();
+		}
+
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			Manager->AddGhost(Recording, Index * Stagger);
+		}
+		Manager->RestartRace();
+	}));
+
+static FAutoConsoleCommandWithWorld GTPGhostStatsCommand(
+	TEXT("TP.Ghost.Stats"),
+	TEXT("Logs ghost playback cost"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		for (TActorIterator<ATP_GhostRaceManager> It(World); It; ++It)
+		{
+			UE_LOG(LogTPGhost, Display, TEXT("%s: %d ghosts, %.3f ms game thread"), *It->GetName(), It->GetNumGhosts(), It->GetLastUpdateMs());
+		}
+	}));
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "TP_GhostRecorderComponent.h"
+#include "TP_GhostRaceManager.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/**
+ * Plays back any number of ghost runs through a single instanced mesh.
+ * Ghosts are never full characters: each one is an instance whose transform is interpolated between recorded samples.
+ */
+UCLASS()
+class THIRDYEARPROJECT_API ATP_GhostRaceManager : public AActor
+{
+	GENERATED_BODY()
+
+	/** One instance per ghost */
+	UPROPERTY(VisibleAnywhere, Category=Ghost)
+	UInstancedStaticMeshComponent* GhostInstances;
+
+public:
+	ATP_GhostRaceManager();
+
+	/** Adds a ghost that starts StartDelay seconds after the race (re)starts, returns its index */
+	int32 AddGhost(const FTP_GhostRecording& Recording, float StartDelay = 0.f);
+
+	/** Removes every ghost */
+	UFUNCTION(BlueprintCallable, Category=Ghost)
+	void ClearGhosts();
+
+	/** Restarts all ghosts from the beginning of their runs */
+	UFUNCTION(BlueprintCallable, Category=Ghost)
+	void RestartRace();
+
+	UFUNCTION(BlueprintCallable, Category=Ghost)
+	int32 GetNumGhosts() const { return Ghosts.Num(); }
+
+	/** Game thread time of the last playback update, in milliseconds */
+	double GetLastUpdateMs() const { return LastUpdateMs; }
+
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+	/** Ghost mesh scale is relative to a 100uu tall, 100uu wide mesh such as /Engine/BasicShapes/Cylinder */
+	UPROPERTY(EditAnywhere, Category=Ghost)
+	FVector GhostScale = FVector(1.1f, 1.1f, 1.92f);
+
+private:
+	struct FGhost
+	{
+		TArray<FTP_GhostSample> Samples;
+		float SampleInterval = 0.05f;
+		float StartDelay = 0.f;
+		uint8 LastState = 0xFF;
+	};
+
+	TArray<FGhost> Ghosts;
+
+	/** Reused every tick so playback doesn't allocate */
+	TArray<FTransform> InstanceTransforms;
+
+	float RaceTime = 0.f;
+	double LastUpdateMs = 0.0;
+};
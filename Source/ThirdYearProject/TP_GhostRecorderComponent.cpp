@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_GhostRecorderComponent.h"
+#include "TP_Quantization.h"
+#include "ThirdYearProjectCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY(LogTPGhost);
+
+namespace TPGhost
+{
+	static constexpr uint32 FileMagic = 0x54504748; // 'TPGH'
+	static constexpr int32 FileVersion = 1;
+
+	/** Smallest encoded sample: state, three one-byte position residuals, a one-byte yaw delta and pitch */
+	static constexpr int32 MinSampleBytes = 6;
+
+	static FString GetFilename(const FString& Name)
+	{
+		return FPaths::ProjectSavedDir() / TEXT("Ghosts") / (Name + TEXT(".tpghost"));
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FTP_GhostRecording& Recording)
+{
+	Ar << Recording.SampleRate;
+	Ar << Recording.NumSamples;
+	Ar << Recording.StartLocation;
+	Ar << Recording.Data;
+	return Ar;
+}
+
+bool FTP_GhostRecording::Decode(TArray<FTP_GhostSample>& OutSamples) const
+{
+	// NumSamples comes from the file; Data can't hold more samples than this, don't reserve for a count it can't back
+	OutSamples.Reset();
+	if (NumSamples < 0 || NumSamples > Data.Num() / TPGhost::MinSampleBytes)
+	{
+		return false;
+	}
+	OutSamples.Reserve(NumSamples);
+
+	const FIntVector Start(FMath::RoundToInt32(StartLocation.X), FMath::RoundToInt32(StartLocation.Y), FMath::RoundToInt32(StartLocation.Z));
+	FIntVector Last = Start;
+	FIntVector Previous = Start;
+	uint16 Yaw = 0;
+
+	int32 Offset = 0;
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		if (Offset >= Data.Num())
+		{
+			return false;
+		}
+
+		FTP_GhostSample& Sample = OutSamples.AddDefaulted_GetRef();
+		Sample.State = Data[Offset++];
+
+		const FIntVector Predicted = Last + (Last - Previous);
+		FIntVector Position;
+		Position.X = Predicted.X + TPQuantization::ReadVarInt(Data, Offset);
+		Position.Y = Predicted.Y + TPQuantization::ReadVarInt(Data, Offset);
+		Position.Z = Predicted.Z + TPQuantization::ReadVarInt(Data, Offset);
+		Yaw = static_cast<uint16>(Yaw + TPQuantization::ReadVarInt(Data, Offset));
+
+		if (Offset >= Data.Num())
+		{
+			return false;
+		}
+		const uint8 Pitch = Data[Offset++];
+
+		Sample.Location = FVector3f(Position.X, Position.Y, Position.Z);
+		Sample.Yaw = FRotator::DecompressAxisFromShort(Yaw);
+		Sample.Pitch = FRotator::NormalizeAxis(FRotator::DecompressAxisFromByte(Pitch));
+
+		Previous = Last;
+		Last = Position;
+	}
+
+	return true;
+}
+
+bool FTP_GhostRecording::SaveToFile(const FString& Name) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = TPGhost::FileMagic;
+	int32 Version = TPGhost::FileVersion;
+	Writer << Magic;
+	Writer << Version;
+	Writer << const_cast<FTP_GhostRecording&>(*this);
+
+	return FFileHelper::SaveArrayToFile(Bytes, *TPGhost::GetFilename(Name));
+}
+
+bool FTP_GhostRecording::LoadFromFile(const FString& Name)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *TPGhost::GetFilename(Name)))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+	if (Magic != TPGhost::FileMagic || Version != TPGhost::FileVersion)
+	{
+		return false;
+	}
+
+	Reader << *this;
+	return !Reader.IsError();
+}
+
+UTP_GhostRecorderComponent::UTP_GhostRecorderComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+void UTP_GhostRecorderComponent::StartRecording()
+{
+	const AActor* Owner = GetOwner();
+	if (Owner == nullptr)
+	{
+		return;
+	}
+
+	Recording = FTP_GhostRecording();
+	Recording.SampleRate = static_cast<uint16>(SampleRate);
+	Recording.StartLocation = FVector3f(FVector(TPQuantization::QuantizePosition(Owner->GetActorLocation())));
+
+	// Roughly a minute of samples up front so recording doesn't reallocate every few seconds
+	Recording.Data.Reserve(SampleRate * 60 * 8);
+
+	LastPosition = TPQuantization::QuantizePosition(Owner->GetActorLocation());
+	PreviousPosition = LastPosition;
+	LastYaw = 0;
+	TimeSinceLastSample = 0.f;
+	bRecording = true;
+
+	RecordSample();
+	SetComponentTickEnabled(true);
+}
+
+void UTP_GhostRecorderComponent::StopRecording()
+{
+	if (!bRecording)
+	{
+		return;
+	}
+
+	bRecording = false;
+	SetComponentTickEnabled(false);
+
+	UE_LOG(LogTPGhost, Log, TEXT("%s: recorded %.1fs in %d bytes (%.1f bytes per sample, %.1f KB per minute)"),
+		*GetNameSafe(GetOwner()), Recording.GetDuration(), Recording.Data.Num(),
+		Recording.NumSamples > 0 ? static_cast<float>(Recording.Data.Num()) / Recording.NumSamples : 0.f,
+		Recording.GetDuration() > 0.f ? Recording.Data.Num() / Recording.GetDuration() * 60.f / 1024.f : 0.f);
+}
+
+bool UTP_GhostRecorderComponent::SaveRecording(const FString& Name) const
+{
+	return Recording.NumSamples > 0 && Recording.SaveToFile(Name);
+}
+
+void UTP_GhostRecorderComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const float SampleInterval = 1.f / Recording.SampleRate;
+	TimeSinceLastSample += DeltaTime;
+
+	// Low frame rates emit several samples at once so the recording keeps its fixed rate
+	while (bRecording && TimeSinceLastSample >= SampleInterval)
+	{
+		TimeSinceLastSample -= SampleInterval;
+		RecordSample();
+	}
+}
+
+void UTP_GhostRecorderComponent::RecordSample()
+{
+	const AThirdYearProjectCharacter* Character = Cast<AThirdYearProjectCharacter>(GetOwner());
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	uint8 State = static_cast<uint8>(FMath::Min(Character->GetJumpCount(), 3) << TPGhostState::JumpCountShift);
+	State |= Character->IsSliding() ? TPGhostState::Sliding : 0;
+	State |= Character->IsWallRunning() ? TPGhostState::WallRunning : 0;
+	State |= Character->GetCharacterMovement()->IsFalling() ? TPGhostState::Airborne : 0;
+
+	const FIntVector Position = TPQuantization::QuantizePosition(Character->GetActorLocation());
+	const FIntVector Residual = Position - (LastPosition + (LastPosition - PreviousPosition));
+
+	const FRotator ViewRotation = Character->GetControlRotation();
+	const uint16 Yaw = FRotator::CompressAxisToShort(ViewRotation.Yaw);
+	const uint8 Pitch = FRotator::CompressAxisToByte(ViewRotation.Pitch);
+
+	TArray<uint8>& Data = Recording.Data;
+	Data.Add(State);
+	TPQuantization::WriteVarInt(Data, Residual.X);
+	TPQuantization::WriteVarInt(Data, Residual.Y);
+	TPQuantization::WriteVarInt(Data, Residual.Z);
+	TPQuantization::WriteVarInt(Data, TPQuantization::AngleDelta16(LastYaw, Yaw));
+	Data.Add(Pitch);
+
+	PreviousPosition = LastPosition;
+	LastPosition = Position;
+	LastYaw = Yaw;
+	++Recording.NumSamples;
+}
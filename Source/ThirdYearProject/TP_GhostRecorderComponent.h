@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "TP_GhostRecorderComponent.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPGhost, Log, All);
+
+/** Movement state bits stored with every ghost sample */
+namespace TPGhostState
+{
+	static constexpr uint8 Sliding = 1 << 0;
+	static constexpr uint8 WallRunning = 1 << 1;
+	static constexpr uint8 Airborne = 1 << 2;
+	static constexpr uint8 JumpCountShift = 3;
+	static constexpr uint8 JumpCountMask = 0x3 << JumpCountShift;
+}
+
+/** One decoded ghost sample */
+struct FTP_GhostSample
+{
+	FVector3f Location;
+	float Yaw = 0.f;
+	float Pitch = 0.f;
+	uint8 State = 0;
+};
+
+/**
+ * A recorded run. Samples are taken at a fixed rate and packed as:
+ * state byte, position residual against a constant-velocity prediction (varint cm per axis),
+ * yaw delta (varint, 16 bit angle) and pitch (8 bit angle). A typical sample is 6-8 bytes.
+ */
+struct FTP_GhostRecording
+{
+	uint16 SampleRate = 20;
+	int32 NumSamples = 0;
+	FVector3f StartLocation = FVector3f::ZeroVector;
+	TArray<uint8> Data;
+
+	/** Expands the packed samples, returns false if the data is corrupt */
+	bool Decode(TArray<FTP_GhostSample>& OutSamples) const;
+
+	/** Duration of the run in seconds */
+	float GetDuration() const { return SampleRate > 0 ? static_cast<float>(NumSamples) / SampleRate : 0.f; }
+
+	bool SaveToFile(const FString& Name) const;
+	bool LoadFromFile(const FString& Name);
+
+	friend FArchive& operator<<(FArchive& Ar, FTP_GhostRecording& Recording);
+};
+
+/** Records the owning AThirdYearProjectCharacter's run as a compact ghost */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class THIRDYEARPROJECT_API UTP_GhostRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UTP_GhostRecorderComponent();
+
+	/** Samples per second */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Ghost, meta=(ClampMin="1", ClampMax="60"))
+	int32 SampleRate = 20;
+
+	/** Starts a new recording, discarding the previous one */
+	UFUNCTION(BlueprintCallable, Category=Ghost)
+	void StartRecording();
+
+	/** Stops recording, the run stays available through GetRecording */
+	UFUNCTION(BlueprintCallable, Category=Ghost)
+	void StopRecording();
+
+	UFUNCTION(BlueprintCallable, Category=Ghost)
+	bool IsRecording() const { return bRecording; }
+
+	/** Writes the last recording to Saved/Ghosts/<Name>.tpghost */
+	UFUNCTION(BlueprintCallable, Category=Ghost)
+	bool SaveRecording(const FString& Name) const;
+
+	const FTP_GhostRecording& GetRecording() const { return Recording; }
+
+protected:
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	void RecordSample();
+
+	FTP_GhostRecording Recording;
+
+	/** Last two quantized positions, used for the constant-velocity prediction */
+	FIntVector LastPosition;
+	FIntVector PreviousPosition;
+	uint16 LastYaw = 0;
+
+	float TimeSinceLastSample = 0.f;
+	bool bRecording = false;
+};
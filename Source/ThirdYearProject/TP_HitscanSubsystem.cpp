@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_HitscanSubsystem.h"
+#include "ThirdYearProject.h"
+#include "ThirdYearProjectProjectile.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTPHitscan);
+
+DECLARE_CYCLE_STAT(TEXT("Hitscan Batch"), STAT_TPHitscanBatch, STATGROUP_ThirdYearProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Traces"), STAT_TPHitscanTraces, STATGROUP_ThirdYearProject);
+
+namespace TPHitscan
+{
+	/** Below this many shots the batch runs inline, task dispatch would cost more than the traces */
+	constexpr int32 MinParallelShots = 8;
+
+	/** Projectiles explode at their collision sphere's centre, this far off the surface they hit */
+	constexpr float ImpactOffset = 5.f;
+}
+
+bool UTP_HitscanSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTP_HitscanSubsystem::QueueShot(const FVector& Start, const FVector& End, const AActor* Shooter)
+{
+	FShot& Shot = Shots.AddDefaulted_GetRef();
+	Shot.Start = Start;
+	Shot.End = End;
+	Shot.Shooter = Shooter;
+}
+
+void UTP_HitscanSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Shots.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_TPHitscanBatch);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// World tickables run after every tick group, so this holds every shot fired this frame
+	UWorld* World = GetWorld();
+	ParallelFor(Shots.Num(), [this, World](int32 Index)
+	{
+		FShot& Shot = Shots[Index];
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TPHitscan), false, Shot.Shooter.Get());
+
+		FHitResult Hit;
+		Shot.bHit = World->LineTraceSingleByChannel(Hit, Shot.Start, Shot.End, ECC_Visibility, QueryParams);
+		Shot.Impact = Hit.ImpactPoint + Hit.ImpactNormal * TPHitscan::ImpactOffset;
+	}, Shots.Num() < TPHitscan::MinParallelShots ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	Impacts.Reset();
+	const float MergeDistanceSq = FMath::Square(ImpactMergeDistance);
+	for (const FShot& Shot : Shots)
+	{
+		if (!Shot.bHit)
+		{
+			continue;
+		}
+
+		const AActor* Shooter = Shot.Shooter.Get();
+		FImpact* Merged = Impacts.FindByPredicate([&Shot, Shooter, MergeDistanceSq](const FImpact& Impact)
+		{
+			return Impact.Shooter == Shooter && FVector::DistSquared(Impact.Location, Shot.Impact) < MergeDistanceSq;
+		});
+
+		if (Merged != nullptr)
+		{
+			++Merged->NumPellets;
+		}
+		else
+		{
+			Impacts.Add({ Shot.Impact, Shooter, 1 });
+		}
+	}
+
+	// One explosion per merged impact, pushing bodies as hard as all of its pellets would have (characters are launched
+	// once at single-pellet strength, as separate pellets would launch them)
+	for (const FImpact& Impact : Impacts)
+	{
+		AThirdYearProjectProjectile::Explode(World, Impact.Location, nullptr, static_cast<float>(Impact.NumPellets));
+	}
+
+	LastNumShots = Shots.Num();
+	LastNumImpacts = Impacts.Num();
+	LastBatchMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	SET_DWORD_STAT(STAT_TPHitscanTraces, LastNumShots);
+
+	Shots.Reset();
+}
+
+TStatId UTP_HitscanSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTP_HitscanSubsystem, STATGROUP_Tickables);
+}
+
+static FAutoConsoleCommandWithWorld GTPHitscanStatsCommand(
+	TEXT("TP.Hitscan.Stats"),
+	TEXT("Logs the size and cost of the last hitscan batch"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UTP_HitscanSubsystem* Subsystem = World->GetSubsystem<UTP_HitscanSubsystem>())
+		{
+			UE_LOG(LogTPHitscan, Display, TEXT("Last batch: %d traces, %d impacts, %.3f ms game thread"),
+				Subsystem->GetLastNumShots(), Subsystem->GetLastNumImpacts(), Subsystem->GetLastBatchMs());
+		}
+	}));
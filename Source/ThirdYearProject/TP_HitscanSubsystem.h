@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TP_HitscanSubsystem.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPHitscan, Log, All);
+
+/**
+ * Resolves hitscan shots in one batch at the end of the frame.
+ *
+ * Weapons only queue traces. Every pellet of every weapon that fired this frame is traced together across worker threads
+ * once all tick groups have run. Each impact goes through the same explosion as a projectile hit (UTP_ExplosionSubsystem),
+ * from the same distance off the surface. Pellets from one shooter landing close together merge into one explosion
+ * that pushes simulated bodies with the force of all of them; characters are launched at one pellet's strength, as
+ * they would be by separate pellets since a launch replaces their velocity.
+ */
+UCLASS(config=Game)
+class THIRDYEARPROJECT_API UTP_HitscanSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** One shooter's impacts from the same frame closer than this become one explosion with their combined force */
+	UPROPERTY(config)
+	float ImpactMergeDistance = 50.f;
+
+	/** Queues one trace, Shooter is ignored by it */
+	void QueueShot(const FVector& Start, const FVector& End, const AActor* Shooter);
+
+	/** Traces resolved and impacts produced by the last batch, and its game thread time */
+	int32 GetLastNumShots() const { return LastNumShots; }
+	int32 GetLastNumImpacts() const { return LastNumImpacts; }
+	double GetLastBatchMs() const { return LastBatchMs; }
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// FTickableGameObject implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FShot
+	{
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+		TWeakObjectPtr<const AActor> Shooter;
+		FVector Impact = FVector::ZeroVector;
+		bool bHit = false;
+	};
+
+	TArray<FShot> Shots;
+
+	struct FImpact
+	{
+		FVector Location = FVector::ZeroVector;
+		const AActor* Shooter = nullptr;
+		int32 NumPellets = 0;
+	};
+
+	/** Reused by Tick */
+	TArray<FImpact> Impacts;
+
+	int32 LastNumShots = 0;
+	int32 LastNumImpacts = 0;
+	double LastBatchMs = 0.0;
+};
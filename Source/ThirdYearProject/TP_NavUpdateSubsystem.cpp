@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_NavUpdateSubsystem.h"
+#include "ThirdYearProject.h"
+#include "Components/PrimitiveComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+
+DEFINE_LOG_CATEGORY(LogTPNavUpdate);
+
+DECLARE_CYCLE_STAT(TEXT("Nav Settle Update"), STAT_TPNavUpdate, STATGROUP_ThirdYearProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav Displaced Bodies"), STAT_TPNavTracked, STATGROUP_ThirdYearProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav Tiles Dirtied"), STAT_TPNavTilesDirtied, STATGROUP_ThirdYearProject);
+
+namespace TPNavUpdate
+{
+	/** Used for clustering and stats when the world has no recast navmesh to ask */
+	constexpr float FallbackTileSize = 1000.f;
+
+	/** Overlap test without building the intersection, walks the smaller set */
+	static bool SharesTile(const TSet<FIntPoint>& A, const TSet<FIntPoint>& B)
+	{
+		const TSet<FIntPoint>& Smaller = A.Num() <= B.Num() ? A : B;
+		const TSet<FIntPoint>& Larger = A.Num() <= B.Num() ? B : A;
+		for (const FIntPoint& Tile : Smaller)
+		{
+			if (Larger.Contains(Tile))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+bool UTP_NavUpdateSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+ARecastNavMesh* UTP_NavUpdateSubsystem::GetNavMesh() const
+{
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	return NavSys ? Cast<ARecastNavMesh>(NavSys->GetDefaultNavDataInstance()) : nullptr;
+}
+
+void UTP_NavUpdateSubsystem::GatherTiles(const FBox& Bounds, TSet<FIntPoint>& OutTiles) const
+{
+	const ARecastNavMesh* NavMesh = GetNavMesh();
+	const float TileSize = NavMesh && NavMesh->TileSizeUU > 0.f ? NavMesh->TileSizeUU : TPNavUpdate::FallbackTileSize;
+	const FIntPoint Min(FMath::FloorToInt32(Bounds.Min.X / TileSize), FMath::FloorToInt32(Bounds.Min.Y / TileSize));
+	const FIntPoint Max(FMath::FloorToInt32(Bounds.Max.X / TileSize), FMath::FloorToInt32(Bounds.Max.Y / TileSize));
+	for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+	{
+		for (int32 X = Min.X; X <= Max.X; ++X)
+		{
+			OutTiles.Add(FIntPoint(X, Y));
+		}
+	}
+}
+
+void UTP_NavUpdateSubsystem::NotifyDisplaced(UPrimitiveComponent* Component, float VelocityChange)
+{
+	if (Component == nullptr)
+	{
+		return;
+	}
+
+	// Shoved again while tumbling or waiting, start settling over
+	for (FTrackedBody& Body : Tracked)
+	{
+		if (Body.Component.Get() == Component)
+		{
+			Body.StillTime = 0.f;
+			Body.bSettled = false;
+			return;
+		}
+	}
+
+	if (VelocityChange < MinTrackedVelocityChange || !Component->CanEverAffectNavigation())
+	{
+		return;
+	}
+
+	FTrackedBody& Body = Tracked.AddDefaulted_GetRef();
+	Body.Component = Component;
+	Body.StartBounds = Component->Bounds.GetBox();
+
+	// Its old footprint is rebuilt once now; while it is off the navmesh its movement dirties nothing
+	Component->SetCanEverAffectNavigation(false);
+
+	ClusterTiles.Reset();
+	GatherTiles(Body.StartBounds, ClusterTiles);
+	TotalTilesDirtied += ClusterTiles.Num();
+}
+
+void UTP_NavUpdateSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Tracked.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_TPNavUpdate);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = Tracked.Num() - 1; Index >= 0; --Index)
+	{
+		FTrackedBody& Body = Tracked[Index];
+		const UPrimitiveComponent* Component = Body.Component.Get();
+		if (Component == nullptr)
+		{
+			Tracked.RemoveAt(Index, 1, false);
+			continue;
+		}
+
+		if (!Body.bSettled)
+		{
+			const bool bStill = !Component->IsAnyRigidBodyAwake() || Component->GetComponentVelocity().SizeSquared() < FMath::Square(SettleSpeed);
+			Body.StillTime = bStill ? Body.StillTime + DeltaTime : 0.f;
+			Body.bSettled = Body.StillTime >= SettleTime;
+		}
+	}
+
+	// The navmesh is still working through earlier rebuilds, don't pile more on
+	const ARecastNavMesh* NavMesh = GetNavMesh();
+	if (NavMesh != nullptr && NavMesh->GetNumRemaningBuildTasks() > MaxPendingTileBuilds)
+	{
+		SET_DWORD_STAT(STAT_TPNavTracked, Tracked.Num());
+		SET_DWORD_STAT(STAT_TPNavTilesDirtied, 0);
+		TotalMs += FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+		return;
+	}
+
+	int32 TilesDirtiedThisFrame = 0;
+	while (TilesDirtiedThisFrame < MaxDirtyTilesPerFrame
+		&& FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) < FrameBudgetMs)
+	{
+		// Oldest settled body first, then every other settled body that shares one of its tiles
+		const int32 SeedIndex = Tracked.IndexOfByPredicate([](const FTrackedBody& Body) { return Body.bSettled; });
+		if (SeedIndex == INDEX_NONE)
+		{
+			break;
+		}
+
+		ClusterTiles.Reset();
+		ClusterIndices.Reset();
+		ClusterIndices.Add(SeedIndex);
+		GatherTiles(Tracked[SeedIndex].Component->Bounds.GetBox(), ClusterTiles);
+
+		for (int32 Index = SeedIndex + 1; Index < Tracked.Num(); ++Index)
+		{
+			if (!Tracked[Index].bSettled)
+			{
+				continue;
+			}
+
+			BodyTiles.Reset();
+			GatherTiles(Tracked[Index].Component->Bounds.GetBox(), BodyTiles);
+			if (TPNavUpdate::SharesTile(BodyTiles, ClusterTiles))
+			{
+				ClusterTiles.Append(BodyTiles);
+				ClusterIndices.Add(Index);
+			}
+		}
+
+		// A cluster bigger than the whole budget still goes through on its own so it can't be starved
+		if (TilesDirtiedThisFrame > 0 && TilesDirtiedThisFrame + ClusterTiles.Num() > MaxDirtyTilesPerFrame)
+		{
+			break;
+		}
+
+		for (int32 ClusterIndex = ClusterIndices.Num() - 1; ClusterIndex >= 0; --ClusterIndex)
+		{
+			const int32 Index = ClusterIndices[ClusterIndex];
+			Tracked[Index].Component->SetCanEverAffectNavigation(true);
+			Tracked.RemoveAt(Index, 1, false);
+		}
+
+		TilesDirtiedThisFrame += ClusterTiles.Num();
+	}
+
+	TotalTilesDirtied += TilesDirtiedThisFrame;
+	TotalMs += FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	SET_DWORD_STAT(STAT_TPNavTracked, Tracked.Num());
+	SET_DWORD_STAT(STAT_TPNavTilesDirtied, TilesDirtiedThisFrame);
+}
+
+TStatId UTP_NavUpdateSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTP_NavUpdateSubsystem, STATGROUP_Tickables);
+}
+
+static FAutoConsoleCommandWithWorld GTPNavUpdateStatsCommand(
+	TEXT("TP.NavUpdate.Stats"),
+	TEXT("Logs navmesh tiles dirtied by explosion-displaced bodies and the time spent managing them"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UTP_NavUpdateSubsystem* Subsystem = World->GetSubsystem<UTP_NavUpdateSubsystem>())
+		{
+			UE_LOG(LogTPNavUpdate, Display, TEXT("%d bodies off the navmesh, %d tiles dirtied, %.2f ms game thread total"),
+				Subsystem->GetNumTracked(), Subsystem->GetTotalTilesDirtied(), Subsystem->GetTotalMs());
+		}
+	}));
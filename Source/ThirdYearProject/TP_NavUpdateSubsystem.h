@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TP_NavUpdateSubsystem.generated.h"
+
+class UPrimitiveComponent;
+class ARecastNavMesh;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPNavUpdate, Log, All);
+
+/**
+ * Keeps explosion-displaced physics bodies from rebuilding the dynamic navmesh every frame.
+ *
+ * A body shoved hard enough to really move is taken off the navmesh straight away, which dirties its old footprint once,
+ * and stays off while it tumbles. Once it has settled it waits in a queue. Each frame, settled bodies are put back onto the
+ * navmesh in clusters of bodies that share tiles, so their dirty areas coalesce. This stops once the frame's tile budget
+ * or game thread budget is spent, or while the navmesh still has a backlog of tile builds. The tiles themselves are
+ * gathered and built on worker threads (bDoFullyAsyncNavDataGathering).
+ */
+UCLASS(config=Game)
+class THIRDYEARPROJECT_API UTP_NavUpdateSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Shoves below this velocity change are left to the navmesh's normal update */
+	UPROPERTY(config)
+	float MinTrackedVelocityChange = 150.f;
+
+	/** A body slower than this for SettleTime seconds (or asleep) has settled */
+	UPROPERTY(config)
+	float SettleSpeed = 10.f;
+
+	UPROPERTY(config)
+	float SettleTime = 0.5f;
+
+	/** Navmesh tiles dirtied by re-adding settled bodies, per frame */
+	UPROPERTY(config)
+	int32 MaxDirtyTilesPerFrame = 4;
+
+	/** Game thread time spent re-adding settled bodies, per frame */
+	UPROPERTY(config)
+	float FrameBudgetMs = 0.5f;
+
+	/** No bodies are re-added while the navmesh has more tile builds than this queued */
+	UPROPERTY(config)
+	int32 MaxPendingTileBuilds = 16;
+
+	/** Called for every simulated body an explosion pushed, with the velocity change it received */
+	void NotifyDisplaced(UPrimitiveComponent* Component, float VelocityChange);
+
+	/** Bodies currently off the navmesh, tumbling or waiting for budget */
+	int32 GetNumTracked() const { return Tracked.Num(); }
+
+	/** Navmesh tiles dirtied and game thread milliseconds spent since the world started */
+	int32 GetTotalTilesDirtied() const { return TotalTilesDirtied; }
+	double GetTotalMs() const { return TotalMs; }
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// FTickableGameObject implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FTrackedBody
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+
+		/** Where the body was when it left the navmesh */
+		FBox StartBounds = FBox(ForceInit);
+
+		float StillTime = 0.f;
+		bool bSettled = false;
+	};
+
+	/** Adds the navmesh tiles overlapped by Bounds to OutTiles */
+	void GatherTiles(const FBox& Bounds, TSet<FIntPoint>& OutTiles) const;
+
+	ARecastNavMesh* GetNavMesh() const;
+
+	TArray<FTrackedBody> Tracked;
+
+	/** Reused by Tick */
+	TSet<FIntPoint> ClusterTiles;
+	TSet<FIntPoint> BodyTiles;
+	TArray<int32> ClusterIndices;
+
+	int32 TotalTilesDirtied = 0;
+	double TotalMs = 0.0;
+};
@@ -0,0 +1,197 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_NetBenchmarkSubsystem.h"
+#include "ThirdYearProjectCharacter.h"
+#include "TP_ReplicationGraph.h"
+#include "EngineUtils.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerStart.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTPNetBenchmark);
+
+namespace TPNetBenchmark
+{
+	/** Frames skipped after changing the bot count so spawning and initial replication don't pollute the measurement */
+	constexpr int32 WarmupFrames = 60;
+
+	/** Bots spread this far around the player starts */
+	constexpr float SpawnRadius = 3000.f;
+
+	/** Chance per second that a bot jumps */
+	constexpr float JumpChance = 0.5f;
+}
+
+bool UTP_NetBenchmarkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTP_NetBenchmarkSubsystem::StartBenchmark(int32 InMaxBots, int32 Step, int32 InFramesPerStep)
+{
+	if (IsRunning())
+	{
+		UE_LOG(LogTPNetBenchmark, Warning, TEXT("A net benchmark is already running"));
+		return;
+	}
+
+	if (UTP_ReplicationGraph::Get(GetWorld()) == nullptr)
+	{
+		UE_LOG(LogTPNetBenchmark, Error, TEXT("Net benchmark needs a server using UTP_ReplicationGraph"));
+		return;
+	}
+
+	MaxBots = FMath::Max(InMaxBots, 0);
+	BotStep = FMath::Max(Step, 1);
+	FramesPerStep = FMath::Max(InFramesPerStep, 1);
+	Frame = 0;
+	Random.Initialize(1234);
+	Results.Reset();
+	Results.AddDefaulted();
+	SetNumBots(0);
+}
+
+void UTP_NetBenchmarkSubsystem::SetNumBots(int32 Count)
+{
+	UWorld* World = GetWorld();
+	while (Bots.Num() > Count)
+	{
+		if (AThirdYearProjectCharacter* Character = Bots.Last().Character.Get())
+		{
+			Character->Destroy();
+		}
+		Bots.Pop(false);
+	}
+
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* BotClass = GameMode && GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf<AThirdYearProjectCharacter>()
+		? GameMode->DefaultPawnClass.Get() : AThirdYearProjectCharacter::StaticClass();
+
+	FVector Center = FVector::ZeroVector;
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		Center = It->GetActorLocation();
+		break;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	while (Bots.Num() < Count)
+	{
+		const FVector Offset(Random.FRandRange(-1.f, 1.f) * TPNetBenchmark::SpawnRadius, Random.FRandRange(-1.f, 1.f) * TPNetBenchmark::SpawnRadius, 0.f);
+		AThirdYearProjectCharacter* Character = World->SpawnActor<AThirdYearProjectCharacter>(BotClass, Center + Offset, FRotator::ZeroRotator, SpawnParams);
+		if (Character == nullptr)
+		{
+			break;
+		}
+
+		// No controller, movement still runs on the server and replicates like a player's
+		Character->GetCharacterMovement()->bRunPhysicsWithNoController = true;
+		Bots.AddDefaulted_GetRef().Character = Character;
+	}
+
+	Results.Last().NumBots = Bots.Num();
+}
+
+void UTP_NetBenchmarkSubsystem::DriveBots(float DeltaTime)
+{
+	for (FBot& Bot : Bots)
+	{
+		AThirdYearProjectCharacter* Character = Bot.Character.Get();
+		if (Character == nullptr)
+		{
+			continue;
+		}
+
+		Bot.TimeToTurn -= DeltaTime;
+		if (Bot.TimeToTurn <= 0.f)
+		{
+			Bot.Direction = FVector(Random.GetUnitVector().GetSafeNormal2D());
+			Bot.TimeToTurn = Random.FRandRange(0.5f, 2.f);
+		}
+
+		Character->AddMovementInput(Bot.Direction);
+		if (Random.FRand() < TPNetBenchmark::JumpChance * DeltaTime)
+		{
+			Character->Jump();
+		}
+	}
+}
+
+void UTP_NetBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!IsRunning())
+	{
+		return;
+	}
+
+	UTP_ReplicationGraph* Graph = UTP_ReplicationGraph::Get(GetWorld());
+	if (Graph == nullptr)
+	{
+		Finish();
+		return;
+	}
+
+	DriveBots(DeltaTime);
+
+	// The graph replicated last frame after the world ticked, so its last time is one frame behind the bots
+	++Frame;
+	if (Frame > TPNetBenchmark::WarmupFrames)
+	{
+		FStepResult& Result = Results.Last();
+		Result.ReplicateMs += Graph->GetLastReplicateMs();
+		Result.NumConnections = Graph->GetNumConnections();
+	}
+
+	if (Frame < TPNetBenchmark::WarmupFrames + FramesPerStep)
+	{
+		return;
+	}
+
+	if (Bots.Num() < MaxBots)
+	{
+		Frame = 0;
+		Results.AddDefaulted();
+		SetNumBots(FMath::Min(Bots.Num() + BotStep, MaxBots));
+		return;
+	}
+
+	Finish();
+}
+
+void UTP_NetBenchmarkSubsystem::Finish()
+{
+	UE_LOG(LogTPNetBenchmark, Display, TEXT("Net benchmark, %d frames per step:"), FramesPerStep);
+	for (const FStepResult& Result : Results)
+	{
+		const double ReplicateMs = Result.ReplicateMs / FramesPerStep;
+		UE_LOG(LogTPNetBenchmark, Display, TEXT("  %d connections + %d bots: %.3f ms ServerReplicateActors, %.4f ms per connection"),
+			Result.NumConnections, Result.NumBots, ReplicateMs, Result.NumConnections > 0 ? ReplicateMs / Result.NumConnections : 0.0);
+	}
+
+	FramesPerStep = 0;
+	SetNumBots(0);
+}
+
+TStatId UTP_NetBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTP_NetBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPNetBenchCommand(
+	TEXT("TP.Net.Bench"),
+	TEXT("Server only: adds bots in steps and logs replication CPU per connection at each count. Usage: TP.Net.Bench [MaxBots=96] [Step=16] [FramesPerStep=300]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTP_NetBenchmarkSubsystem* Benchmark = World->GetSubsystem<UTP_NetBenchmarkSubsystem>())
+		{
+			Benchmark->StartBenchmark(
+				Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 96,
+				Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 16,
+				Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 300);
+		}
+	}));
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TP_NetBenchmarkSubsystem.generated.h"
+
+class AThirdYearProjectCharacter;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPNetBenchmark, Log, All);
+
+/**
+ * Measures server replication cost as the player count grows.
+ *
+ * Adds server-side bot characters in steps (they run around and jump without a controller), and after a warmup logs
+ * the average ServerReplicateActors time of UTP_ReplicationGraph for each step, total and per connection. Run it on a
+ * headless localhost server with a few headless clients connected so the per-connection numbers mean something:
+ *
+ *   UnrealEditor-Cmd ThirdYearProject.uproject /Game/FirstPerson/Maps/FirstPersonMap -server -nullrhi -log
+ *   UnrealEditor-Cmd ThirdYearProject.uproject 127.0.0.1 -game -nullrhi -nosound -log   (once per client)
+ *   then on the server console: TP.Net.Bench [MaxBots=96] [Step=16] [FramesPerStep=300]
+ */
+UCLASS()
+class THIRDYEARPROJECT_API UTP_NetBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Steps bots from 0 to MaxBots, Step at a time, measuring FramesPerStep frames at each count */
+	void StartBenchmark(int32 MaxBots, int32 Step, int32 FramesPerStep);
+
+	bool IsRunning() const { return FramesPerStep > 0; }
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// FTickableGameObject implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FBot
+	{
+		TWeakObjectPtr<AThirdYearProjectCharacter> Character;
+		FVector Direction = FVector::ForwardVector;
+		float TimeToTurn = 0.f;
+	};
+
+	struct FStepResult
+	{
+		int32 NumBots = 0;
+		int32 NumConnections = 0;
+		double ReplicateMs = 0.0;
+	};
+
+	void SetNumBots(int32 Count);
+	void DriveBots(float DeltaTime);
+	void Finish();
+
+	TArray<FBot> Bots;
+	TArray<FStepResult> Results;
+	FRandomStream Random;
+
+	int32 MaxBots = 0;
+	int32 BotStep = 0;
+	int32 FramesPerStep = 0;
+	int32 Frame = 0;
+};
@@ -0,0 +1,10 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_ParkourAIController.h"
+#include "TP_ParkourPathFollowingComponent.h"
+
+ATP_ParkourAIController::ATP_ParkourAIController(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UTP_ParkourPathFollowingComponent>(TEXT("PathFollowingComponent")))
+{
+}
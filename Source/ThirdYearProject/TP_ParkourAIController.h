@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "TP_ParkourAIController.generated.h"
+
+/** AI controller whose path following performs parkour nav links, see UTP_ParkourPathFollowingComponent */
+UCLASS()
+class THIRDYEARPROJECT_API ATP_ParkourAIController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	ATP_ParkourAIController(const FObjectInitializer& ObjectInitializer);
+};
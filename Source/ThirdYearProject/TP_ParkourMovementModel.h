@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * The launch rules used by AThirdYearProjectCharacter's jump, double jump, slide jump and wall-run.
+ * Kept in one place so offline tools (nav link generation, trajectory prediction) simulate exactly what the character does.
+ */
+struct FTP_ParkourMovementModel
+{
+	/** Wall jump: pushed away from the wall, a bit forward and up */
+	static constexpr float WallJumpAwayStrength = 600.f;
+	static constexpr float WallJumpForwardStrength = 400.f;
+	static constexpr float WallJumpUpStrength = 800.f;
+
+	/** Slide jump: forward-biased launch that keeps slide momentum */
+	static constexpr float SlideJumpForwardScale = 1.2f;
+	static constexpr float SlideJumpStrength = 800.f;
+
+	/** Wall-run: boost along the wall and lowered gravity */
+	static constexpr float WallRunSpeed = 1200.f;
+	static constexpr float WallRunGravityScale = 0.3f;
+	static constexpr float WallRunMaxWalkSpeed = 1000.f;
+	static constexpr float WallProbeDistance = 100.f;
+
+	/** Parkour links that wall-jump hold the wall-run this long first, in the builder and when AI replays them */
+	static constexpr float LinkWallRunHoldTime = 0.5f;
+
+	/** Slide starts above this speed and is held at least at SlideMinSpeed */
+	static constexpr float SlideStartSpeed = 200.f;
+	static constexpr float SlideMinSpeed = 1200.f;
+	static constexpr float SlideCapsuleHalfHeight = 48.f;
+
+	static constexpr float WalkSpeed = 600.f;
+	static constexpr float SprintSpeed = 900.f;
+	static constexpr float JumpZVelocity = 500.f;
+	static constexpr int32 MaxJumps = 2;
+
+	/** Launch velocity of a jump off a wall-run */
+	static FVector GetWallJumpVelocity(const FVector& WallNormal, const FVector& Forward)
+	{
+		return WallNormal * WallJumpAwayStrength + Forward * WallJumpForwardStrength + FVector(0, 0, WallJumpUpStrength);
+	}
+
+	/** Launch velocity of a jump out of a slide */
+	static FVector GetSlideJumpVelocity(const FVector& Forward)
+	{
+		return (Forward * SlideJumpForwardScale + FVector(0, 0, 1)) * SlideJumpStrength;
+	}
+
+	/** Launch velocity of the second (air) jump; added to the current horizontal velocity */
+	static FVector GetDoubleJumpVelocity(const FVector& CurrentVelocity, float InJumpZVelocity)
+	{
+		return FVector(CurrentVelocity.X, CurrentVelocity.Y, InJumpZVelocity);
+	}
+
+	/** Direction along the wall, picked to match the way the character is facing */
+	static FVector GetWallRunDirection(const FVector& WallNormal, const FVector& Forward)
+	{
+		const FVector Direction = FVector::CrossProduct(WallNormal, FVector::UpVector);
+		return FVector::DotProduct(Direction, Forward) > 0 ? Direction : -Direction;
+	}
+
+	/** Velocity after ACharacter::LaunchCharacter with the given override flags */
+	static FVector ApplyLaunch(const FVector& CurrentVelocity, const FVector& LaunchVelocity, bool bXYOverride, bool bZOverride)
+	{
+		FVector Result = LaunchVelocity;
+		if (!bXYOverride)
+		{
+			Result.X += CurrentVelocity.X;
+			Result.Y += CurrentVelocity.Y;
+		}
+		if (!bZOverride)
+		{
+			Result.Z += CurrentVelocity.Z;
+		}
+		return Result;
+	}
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_ParkourNavLinkActor.h"
+#include "AI/Navigation/NavLinkDefinition.h"
+#include "AI/NavigationSystemHelpers.h"
+#include "Components/SceneComponent.h"
+
+UTP_NavArea_Parkour::UTP_NavArea_Parkour()
+{
+	DefaultCost = 2.f;
+	DrawColor = FColor::Orange;
+}
+
+ATP_ParkourNavLinkActor::ATP_ParkourNavLinkActor()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Links are stored in world space, the actor itself always sits at the origin
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	RootComponent->SetMobility(EComponentMobility::Static);
+
+	SetCanBeDamaged(false);
+
+#if WITH_EDITORONLY_DATA
+	// One actor holds every link in the map, World Partition must not stream it out with the cell at the origin
+	bIsSpatiallyLoaded = false;
+#endif
+}
+
+void ATP_ParkourNavLinkActor::SetLinks(TArray<FTP_ParkourLink>&& InLinks)
+{
+	Links = MoveTemp(InLinks);
+}
+
+const FTP_ParkourLink* ATP_ParkourNavLinkActor::FindLink(const FVector& Start, const FVector& End, float Tolerance) const
+{
+	const FVector3f Start3f(Start);
+	const FVector3f End3f(End);
+	const float ToleranceSq = Tolerance * Tolerance;
+
+	const FTP_ParkourLink* BestLink = nullptr;
+	float BestDistanceSq = ToleranceSq * 2.f;
+	for (const FTP_ParkourLink& Link : Links)
+	{
+		const float StartDistanceSq = FVector3f::DistSquared(Link.Start, Start3f);
+		const float EndDistanceSq = FVector3f::DistSquared(Link.End, End3f);
+		if (StartDistanceSq <= ToleranceSq && EndDistanceSq <= ToleranceSq && StartDistanceSq + EndDistanceSq < BestDistanceSq)
+		{
+			BestLink = &Link;
+			BestDistanceSq = StartDistanceSq + EndDistanceSq;
+		}
+	}
+	return BestLink;
+}
+
+void ATP_ParkourNavLinkActor::BuildNavigationLinks(TArray<FNavigationLink>& OutLinks) const
+{
+	OutLinks.Reserve(OutLinks.Num() + Links.Num());
+	for (const FTP_ParkourLink& Link : Links)
+	{
+		FNavigationLink& NavLink = OutLinks.Emplace_GetRef(FVector(Link.Start), FVector(Link.End));
+		NavLink.Direction = ENavLinkDirection::LeftToRight;
+		NavLink.SnapRadius = SnapRadius;
+		NavLink.SetAreaClass(UTP_NavArea_Parkour::StaticClass());
+	}
+}
+
+bool ATP_ParkourNavLinkActor::GetNavigationLinksClasses(TArray<TSubclassOf<UNavLinkDefinition> >& OutClasses) const
+{
+	return false;
+}
+
+bool ATP_ParkourNavLinkActor::GetNavigationLinksArray(TArray<FNavigationLink>& OutLink, TArray<FNavigationSegmentLink>& OutSegments) const
+{
+	BuildNavigationLinks(OutLink);
+	return Links.Num() > 0;
+}
+
+FBox ATP_ParkourNavLinkActor::GetNavigationBounds() const
+{
+	FBox Bounds(ForceInit);
+	for (const FTP_ParkourLink& Link : Links)
+	{
+		Bounds += FVector(Link.Start);
+		Bounds += FVector(Link.End);
+	}
+	return Bounds.ExpandBy(SnapRadius);
+}
+
+bool ATP_ParkourNavLinkActor::IsNavigationRelevant() const
+{
+	return Links.Num() > 0;
+}
+
+void ATP_ParkourNavLinkActor::GetNavigationData(FNavigationRelevantData& Data) const
+{
+	TArray<FNavigationLink> NavLinks;
+	BuildNavigationLinks(NavLinks);
+	NavigationHelper::ProcessNavLinkAndAppend(&Data.Modifiers, this, NavLinks);
+}
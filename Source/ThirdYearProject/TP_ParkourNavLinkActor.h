@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "NavLinkHostInterface.h"
+#include "AI/Navigation/NavRelevantInterface.h"
+#include "NavAreas/NavArea.h"
+#include "TP_ParkourNavLinkActor.generated.h"
+
+/** Which parkour moves a link needs, as bit flags */
+UENUM(BlueprintType, meta=(Bitflags, UseEnumValuesAsMaskValuesInEditor="true"))
+enum class ETP_ParkourMove : uint8
+{
+	None		= 0,
+	Jump		= 1 << 0,
+	DoubleJump	= 1 << 1,
+	SlideJump	= 1 << 2,
+	WallRun		= 1 << 3,
+	WallJump	= 1 << 4,
+};
+ENUM_CLASS_FLAGS(ETP_ParkourMove);
+
+/**
+ * One pre-simulated parkour traversal. Everything the AI needs to perform it is stored,
+ * so following the link at runtime is a single launch instead of a simulation.
+ */
+USTRUCT(BlueprintType)
+struct FTP_ParkourLink
+{
+	GENERATED_BODY()
+
+	/** Take-off point on the navmesh */
+	UPROPERTY(VisibleAnywhere, Category=Parkour)
+	FVector3f Start = FVector3f::ZeroVector;
+
+	/** Landing point on the navmesh */
+	UPROPERTY(VisibleAnywhere, Category=Parkour)
+	FVector3f End = FVector3f::ZeroVector;
+
+	/** Horizontal take-off direction and speed the character must have when starting the move */
+	UPROPERTY(VisibleAnywhere, Category=Parkour)
+	FVector3f TakeOffVelocity = FVector3f::ZeroVector;
+
+	/** ETP_ParkourMove flags */
+	UPROPERTY(VisibleAnywhere, Category=Parkour)
+	uint8 Moves = 0;
+
+	/** Simulated time of flight in tenths of a second */
+	UPROPERTY(VisibleAnywhere, Category=Parkour)
+	uint8 FlightTimeDeciseconds = 0;
+};
+
+/** Nav area used by parkour links, costs more than walking so AI only takes them when they are a real shortcut */
+UCLASS()
+class THIRDYEARPROJECT_API UTP_NavArea_Parkour : public UNavArea
+{
+	GENERATED_BODY()
+
+public:
+	UTP_NavArea_Parkour();
+};
+
+/**
+ * Holds every parkour link generated for a map by the offline nav link builder and feeds them to the
+ * navigation system as one-way point links.
+ */
+UCLASS(NotBlueprintable)
+class THIRDYEARPROJECT_API ATP_ParkourNavLinkActor : public AActor, public INavLinkHostInterface, public INavRelevantInterface
+{
+	GENERATED_BODY()
+
+public:
+	ATP_ParkourNavLinkActor();
+
+	/** Replaces the stored links, called by the offline builder */
+	void SetLinks(TArray<FTP_ParkourLink>&& InLinks);
+
+	/** All stored links */
+	const TArray<FTP_ParkourLink>& GetLinks() const { return Links; }
+
+	/** Finds the link whose end points are closest to the given path segment, returns nullptr if none are within Tolerance */
+	const FTP_ParkourLink* FindLink(const FVector& Start, const FVector& End, float Tolerance = 50.f) const;
+
+	// INavLinkHostInterface
+	virtual bool GetNavigationLinksClasses(TArray<TSubclassOf<class UNavLinkDefinition> >& OutClasses) const override;
+	virtual bool GetNavigationLinksArray(TArray<FNavigationLink>& OutLink, TArray<FNavigationSegmentLink>& OutSegments) const override;
+	// End INavLinkHostInterface
+
+	// INavRelevantInterface
+	virtual FBox GetNavigationBounds() const override;
+	virtual bool IsNavigationRelevant() const override;
+	virtual void GetNavigationData(FNavigationRelevantData& Data) const override;
+	// End INavRelevantInterface
+
+protected:
+	/** Generated links, stored compactly and expanded into FNavigationLink only when the navmesh asks for them */
+	UPROPERTY(VisibleAnywhere, Category=Parkour)
+	TArray<FTP_ParkourLink> Links;
+
+	/** Snap radius used when connecting link ends to the navmesh */
+	UPROPERTY(EditAnywhere, Category=Parkour)
+	float SnapRadius = 40.f;
+
+private:
+	void BuildNavigationLinks(TArray<FNavigationLink>& OutLinks) const;
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_ParkourPathFollowingComponent.h"
+#include "ThirdYearProjectCharacter.h"
+#include "TP_ParkourNavLinkActor.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/NavMovementComponent.h"
+#include "NavMesh/NavMeshPath.h"
+
+namespace TPParkourPathFollowing
+{
+	/** A launch that hasn't left the ground by then failed, the segment is walked instead */
+	constexpr float MaxTakeOffTime = 0.5f;
+}
+
+const ATP_ParkourNavLinkActor* UTP_ParkourPathFollowingComponent::GetLinkActor()
+{
+	if (!bLinkActorSearched)
+	{
+		bLinkActorSearched = true;
+		for (TActorIterator<ATP_ParkourNavLinkActor> It(GetWorld()); It; ++It)
+		{
+			LinkActor = *It;
+			break;
+		}
+	}
+	return LinkActor.Get();
+}
+
+void UTP_ParkourPathFollowingComponent::SetMoveSegment(int32 SegmentStartIndex)
+{
+	Super::SetMoveSegment(SegmentStartIndex);
+
+	bTraversingLink = false;
+	if (!Path.IsValid() || !Path->GetPathPoints().IsValidIndex(SegmentStartIndex + 1))
+	{
+		return;
+	}
+
+	const FNavPathPoint& StartPoint = Path->GetPathPoints()[SegmentStartIndex];
+	if (!FNavMeshNodeFlags(StartPoint.Flags).IsNavLink())
+	{
+		return;
+	}
+
+	AThirdYearProjectCharacter* Character = MovementComp ? Cast<AThirdYearProjectCharacter>(MovementComp->GetOwner()) : nullptr;
+	const ATP_ParkourNavLinkActor* Links = Character ? GetLinkActor() : nullptr;
+	const FTP_ParkourLink* Link = Links ? Links->FindLink(StartPoint.Location, Path->GetPathPoints()[SegmentStartIndex + 1].Location) : nullptr;
+	if (Link == nullptr)
+	{
+		return;
+	}
+
+	Character->TraverseParkourLink(*Link);
+	bTraversingLink = true;
+	bLeftGround = false;
+	TraversalStartTime = GetWorld()->GetTimeSeconds();
+}
+
+bool UTP_ParkourPathFollowingComponent::UpdateTraversal()
+{
+	if (!bTraversingLink || MovementComp == nullptr)
+	{
+		return false;
+	}
+
+	if (MovementComp->IsFalling())
+	{
+		bLeftGround = true;
+	}
+	else if (bLeftGround || GetWorld()->GetTimeSeconds() - TraversalStartTime > TPParkourPathFollowing::MaxTakeOffTime)
+	{
+		bTraversingLink = false;
+	}
+	return bTraversingLink;
+}
+
+void UTP_ParkourPathFollowingComponent::UpdatePathSegment()
+{
+	// No reach or block checks mid-air, the segment ends where the character lands
+	if (!UpdateTraversal())
+	{
+		Super::UpdatePathSegment();
+	}
+}
+
+void UTP_ParkourPathFollowingComponent::FollowPathSegment(float DeltaTime)
+{
+	if (!bTraversingLink)
+	{
+		Super::FollowPathSegment(DeltaTime);
+	}
+}
+
+void UTP_ParkourPathFollowingComponent::OnPathFinished(const FPathFollowingResult& Result)
+{
+	bTraversingLink = false;
+	Super::OnPathFinished(Result);
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "TP_ParkourPathFollowingComponent.generated.h"
+
+class ATP_ParkourNavLinkActor;
+
+/**
+ * Path following that performs parkour links instead of walking them.
+ *
+ * When a path segment starts on a nav link that ATP_ParkourNavLinkActor generated, the character replays the stored
+ * move through AThirdYearProjectCharacter::TraverseParkourLink. Steering and segment updates pause until it lands,
+ * so air control doesn't bend the launch, then normal following resumes from wherever it came down.
+ */
+UCLASS()
+class THIRDYEARPROJECT_API UTP_ParkourPathFollowingComponent : public UPathFollowingComponent
+{
+	GENERATED_BODY()
+
+public:
+	bool IsTraversingParkourLink() const { return bTraversingLink; }
+
+protected:
+	virtual void SetMoveSegment(int32 SegmentStartIndex) override;
+	virtual void UpdatePathSegment() override;
+	virtual void FollowPathSegment(float DeltaTime) override;
+	virtual void OnPathFinished(const FPathFollowingResult& Result) override;
+
+private:
+	/** The map's link actor, looked up once */
+	const ATP_ParkourNavLinkActor* GetLinkActor();
+
+	/** True while a launched link hasn't landed yet */
+	bool UpdateTraversal();
+
+	TWeakObjectPtr<const ATP_ParkourNavLinkActor> LinkActor;
+	bool bLinkActorSearched = false;
+
+	bool bTraversingLink = false;
+	bool bLeftGround = false;
+	float TraversalStartTime = 0.f;
+};
@@ -0,0 +1,566 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_ParkourSimulation.h"
+#include "TP_ParkourMovementModel.h"
+#include "ThirdYearProjectCharacter.h"
+#include "ThirdYearProjectProjectile.h"
+#include "TP_WeaponComponent.h"
+#include "TP_WeaponInventoryComponent.h"
+#include "TP_ExplosionSubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SphereComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerStart.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTPSimulation);
+
+namespace TPSimulation
+{
+	constexpr int32 MaxProjectilesPerEnvironment = 16;
+
+	// UCharacterMovementComponent's fixed braking constants
+	constexpr float BrakingSubStepTime = 1.f / 33.f;
+	constexpr float BrakeToStopVelocity = 10.f;
+
+	/** UCharacterMovementComponent::ApplyVelocityBraking: friction and a constant deceleration against the velocity, substepped */
+	static void ApplyVelocityBraking(const FTP_SimSettings& Settings, FVector& Velocity, float Friction, float BrakingDeceleration, float DeltaTime)
+	{
+		Friction = FMath::Max(Friction * FMath::Max(Settings.BrakingFrictionFactor, 0.f), 0.f);
+		BrakingDeceleration = FMath::Max(BrakingDeceleration, 0.f);
+		if (Velocity.IsZero() || (Friction == 0.f && BrakingDeceleration == 0.f))
+		{
+			return;
+		}
+
+		const FVector OldVelocity = Velocity;
+		const FVector ReverseAcceleration = -BrakingDeceleration * Velocity.GetSafeNormal();
+		float RemainingTime = DeltaTime;
+		while (RemainingTime >= UE_KINDA_SMALL_NUMBER)
+		{
+			const float StepTime = RemainingTime > BrakingSubStepTime && Friction > 0.f ? FMath::Min(BrakingSubStepTime, RemainingTime * 0.5f) : RemainingTime;
+			RemainingTime -= StepTime;
+			Velocity += (-Friction * Velocity + ReverseAcceleration) * StepTime;
+
+			// Braking never reverses the velocity
+			if (FVector::DotProduct(Velocity, OldVelocity) <= 0.f)
+			{
+				Velocity = FVector::ZeroVector;
+				return;
+			}
+		}
+
+		if (Velocity.SizeSquared() <= UE_KINDA_SMALL_NUMBER || (BrakingDeceleration > 0.f && Velocity.SizeSquared() <= FMath::Square(BrakeToStopVelocity)))
+		{
+			Velocity = FVector::ZeroVector;
+		}
+	}
+
+	/** UCharacterMovementComponent::CalcVelocity: brakes without input or over MaxSpeed, otherwise friction turns the velocity towards the input */
+	static void CalcVelocity(const FTP_SimSettings& Settings, FVector& Velocity, const FVector& Acceleration, float MaxSpeed, float Friction, float BrakingDeceleration, float DeltaTime)
+	{
+		Friction = FMath::Max(Friction, 0.f);
+		const bool bZeroAcceleration = Acceleration.IsZero();
+		const bool bVelocityOverMax = Velocity.SizeSquared() > FMath::Square(MaxSpeed) * 1.01f;
+
+		if (bZeroAcceleration || bVelocityOverMax)
+		{
+			const FVector OldVelocity = Velocity;
+			ApplyVelocityBraking(Settings, Velocity, Settings.bUseSeparateBrakingFriction ? Settings.BrakingFriction : Friction, BrakingDeceleration, DeltaTime);
+
+			// Braking doesn't take the speed below MaxSpeed while still accelerating the same way
+			if (bVelocityOverMax && Velocity.SizeSquared() < FMath::Square(MaxSpeed) && FVector::DotProduct(Acceleration, OldVelocity) > 0.f)
+			{
+				Velocity = OldVelocity.GetSafeNormal() * MaxSpeed;
+			}
+		}
+		else
+		{
+			const float Speed = Velocity.Size();
+			Velocity -= (Velocity - Acceleration.GetSafeNormal() * Speed) * FMath::Min(DeltaTime * Friction, 1.f);
+		}
+
+		if (!bZeroAcceleration)
+		{
+			const float MaxInputSpeed = Velocity.SizeSquared() > FMath::Square(MaxSpeed) * 1.01f ? Velocity.Size() : MaxSpeed;
+			Velocity = (Velocity + Acceleration * DeltaTime).GetClampedToMaxSize(MaxInputSpeed);
+		}
+	}
+
+	/** UCharacterMovementComponent::GetFallingLateralAcceleration: input scaled by AirControl, boosted when nearly still */
+	static FVector GetFallingLateralAcceleration(const FTP_SimSettings& Settings, const FVector& Acceleration, const FVector& Velocity)
+	{
+		FVector FallAcceleration(Acceleration.X, Acceleration.Y, 0.f);
+		if (FallAcceleration.IsZero())
+		{
+			return FallAcceleration;
+		}
+
+		float TickAirControl = Settings.AirControl;
+		if (TickAirControl != 0.f && Settings.AirControlBoostMultiplier > 0.f && Velocity.SizeSquared2D() < FMath::Square(Settings.AirControlBoostVelocityThreshold))
+		{
+			TickAirControl = FMath::Min(1.f, Settings.AirControlBoostMultiplier * TickAirControl);
+		}
+		return (FallAcceleration * TickAirControl).GetClampedToMaxSize(Settings.MaxAcceleration);
+	}
+}
+
+void FTP_SimSettings::ReadFromDefaults(const UWorld* World)
+{
+	// The pawn the game mode actually spawns, which may be a blueprint with its own values
+	const AGameModeBase* GameMode = World ? World->GetAuthGameMode() : nullptr;
+	const UClass* PawnClass = GameMode && GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf<AThirdYearProjectCharacter>()
+		? GameMode->DefaultPawnClass.Get() : AThirdYearProjectCharacter::StaticClass();
+	const AThirdYearProjectCharacter* Character = PawnClass->GetDefaultObject<AThirdYearProjectCharacter>();
+
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	CapsuleRadius = Capsule->GetUnscaledCapsuleRadius();
+	CapsuleHalfHeight = Capsule->GetUnscaledCapsuleHalfHeight();
+
+	const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+	MaxStepHeight = Movement->MaxStepHeight;
+	WalkableFloorZ = Movement->GetWalkableFloorZ();
+	MaxAcceleration = Movement->MaxAcceleration;
+	BrakingDecelerationWalking = Movement->BrakingDecelerationWalking;
+	BrakingDecelerationFalling = Movement->BrakingDecelerationFalling;
+	GroundFriction = Movement->GroundFriction;
+	FallingLateralFriction = Movement->FallingLateralFriction;
+	BrakingFriction = Movement->BrakingFriction;
+	BrakingFrictionFactor = Movement->BrakingFrictionFactor;
+	bUseSeparateBrakingFriction = Movement->bUseSeparateBrakingFriction;
+	AirControl = Movement->AirControl;
+	AirControlBoostMultiplier = Movement->AirControlBoostMultiplier;
+	AirControlBoostVelocityThreshold = Movement->AirControlBoostVelocityThreshold;
+	GravityScale = Movement->GravityScale;
+	WallRunCooldown = Character->GetWallRunCooldown();
+
+	// The first weapon carried and what it fires
+	const UTP_WeaponComponent* Weapon = nullptr;
+	for (const TSubclassOf<UTP_WeaponComponent>& WeaponClass : Character->GetWeaponInventory()->StartingWeapons)
+	{
+		if (WeaponClass)
+		{
+			Weapon = WeaponClass->GetDefaultObject<UTP_WeaponComponent>();
+			break;
+		}
+	}
+	if (Weapon)
+	{
+		MuzzleOffset = Weapon->MuzzleOffset;
+	}
+
+	const AThirdYearProjectProjectile* Projectile = Weapon && Weapon->ProjectileClass
+		? Weapon->ProjectileClass->GetDefaultObject<AThirdYearProjectProjectile>() : GetDefault<AThirdYearProjectProjectile>();
+	const UProjectileMovementComponent* ProjectileMovement = Projectile->GetProjectileMovement();
+	ProjectileSpeed = ProjectileMovement->InitialSpeed > 0.f ? ProjectileMovement->InitialSpeed : ProjectileMovement->Velocity.Size();
+	ProjectileMaxSpeed = ProjectileMovement->MaxSpeed;
+	ProjectileGravityScale = ProjectileMovement->ProjectileGravityScale;
+	ProjectileRadius = Projectile->GetCollisionComp()->GetUnscaledSphereRadius();
+	ProjectileLifeSpan = Projectile->InitialLifeSpan;
+
+	const UTP_ExplosionSubsystem* Explosion = GetDefault<UTP_ExplosionSubsystem>();
+	ExplosionRadius = Explosion->ExplosionRadius;
+	ExplosionForce = Explosion->ExplosionForce;
+}
+
+void FTP_SimEnvironment::Step(const UWorld* World, const FTP_SimSettings& Settings, float DeltaTime)
+{
+	for (int32 Index = 0; Index < Characters.Num(); ++Index)
+	{
+		StepCharacter(World, Settings, Characters[Index], Inputs[Index], DeltaTime);
+	}
+	StepProjectiles(World, Settings, DeltaTime);
+	SimulatedSeconds += DeltaTime;
+}
+
+void FTP_SimEnvironment::StepCharacter(const UWorld* World, const FTP_SimSettings& Settings, FTP_SimCharacterState& Character, const FTP_SimInput& Input, float DeltaTime)
+{
+	using namespace TPSimulation;
+
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TPSimulation), false);
+	constexpr float SlideCapsuleHalfHeight = FTP_ParkourMovementModel::SlideCapsuleHalfHeight;
+
+	// StartSlide and StopSlide resize the capsule around its centre, the sim keeps the feet where they are instead
+	auto SetSliding = [&Character, &Settings](bool bSliding)
+	{
+		if (Character.bSliding != bSliding)
+		{
+			Character.bSliding = bSliding;
+			Character.Location.Z += bSliding ? SlideCapsuleHalfHeight - Settings.CapsuleHalfHeight : Settings.CapsuleHalfHeight - SlideCapsuleHalfHeight;
+		}
+	};
+
+	Character.Yaw = FRotator::NormalizeAxis(Character.Yaw + Input.YawDelta);
+	const FRotator Rotation(0.f, Character.Yaw, 0.f);
+	const FVector Forward = Rotation.Vector();
+	const FVector Right = FRotationMatrix(Rotation).GetUnitAxis(EAxis::Y);
+	const FVector MoveDirection = (Forward * Input.Move.Y + Right * Input.Move.X).GetSafeNormal();
+
+	// Jump, same branches as AThirdYearProjectCharacter::Jump
+	if (Input.bJump && !Character.bJumpHeld && Character.JumpCount < FTP_ParkourMovementModel::MaxJumps)
+	{
+		if (Character.bSliding)
+		{
+			Character.Velocity = FTP_ParkourMovementModel::GetSlideJumpVelocity(Forward);
+			SetSliding(false);
+		}
+		else if (Character.bWallRunning)
+		{
+			Character.bWallRunning = false;
+			Character.WallRunCooldownLeft = Settings.WallRunCooldown;
+			Character.Velocity = FTP_ParkourMovementModel::GetWallJumpVelocity(Character.WallNormal, Forward);
+		}
+		else if (Character.JumpCount == 0)
+		{
+			Character.Velocity.Z = FTP_ParkourMovementModel::JumpZVelocity;
+		}
+		else
+		{
+			Character.Velocity = FTP_ParkourMovementModel::ApplyLaunch(Character.Velocity, FTP_ParkourMovementModel::GetDoubleJumpVelocity(Character.Velocity, FTP_ParkourMovementModel::JumpZVelocity), false, true);
+		}
+		Character.bFalling = true;
+		++Character.JumpCount;
+	}
+	Character.bJumpHeld = Input.bJump;
+
+	// Slide is held, and ends when the character slows down. Like StartSlide it only raises the speed cap (MaxWalkSpeed)
+	// and lowers the capsule, the speed itself still comes from acceleration
+	const float Speed = Character.Velocity.Size2D();
+	if (Input.bSlide && !Character.bSliding && !Character.bFalling && Speed > FTP_ParkourMovementModel::SlideStartSpeed)
+	{
+		SetSliding(true);
+		Character.SlideMaxSpeed = FMath::Max(Speed, FTP_ParkourMovementModel::SlideMinSpeed);
+	}
+	else if (Character.bSliding && (!Input.bSlide || Speed < FTP_ParkourMovementModel::SlideStartSpeed))
+	{
+		SetSliding(false);
+	}
+
+	const float HalfHeight = Character.bSliding ? SlideCapsuleHalfHeight : Settings.CapsuleHalfHeight;
+	const FCollisionShape Capsule = FCollisionShape::MakeCapsule(Settings.CapsuleRadius, HalfHeight);
+
+	if (Input.bFire && !Character.bFireHeld && Projectiles.Num() < MaxProjectilesPerEnvironment)
+	{
+		FTP_SimProjectile& Projectile = Projectiles.AddDefaulted_GetRef();
+		Projectile.Location = Character.Location + Rotation.RotateVector(Settings.MuzzleOffset);
+		Projectile.Velocity = Forward * Settings.ProjectileSpeed;
+		Projectile.LifeLeft = Settings.ProjectileLifeSpan;
+	}
+	Character.bFireHeld = Input.bFire;
+
+	// MaxWalkSpeed as the character sets it, the movement component also caps falling speed with it
+	const float MaxSpeed = Character.bWallRunning ? FTP_ParkourMovementModel::WallRunMaxWalkSpeed
+		: Character.bSliding ? Character.SlideMaxSpeed
+		: Input.bSprint ? FTP_ParkourMovementModel::SprintSpeed : FTP_ParkourMovementModel::WalkSpeed;
+	const FVector Acceleration = MoveDirection * Settings.MaxAcceleration;
+
+	FHitResult Hit;
+	if (Character.bFalling)
+	{
+		// Wall-run: same probes as CanWallRun, lost when the wall ends
+		if (Character.bWallRunning)
+		{
+			if (!World->LineTraceSingleByChannel(Hit, Character.Location, Character.Location - Character.WallNormal * FTP_ParkourMovementModel::WallProbeDistance, ECC_Visibility, QueryParams))
+			{
+				Character.bWallRunning = false;
+				Character.WallRunCooldownLeft = Settings.WallRunCooldown;
+			}
+		}
+		else if (Character.WallRunCooldownLeft <= 0.f)
+		{
+			if (World->LineTraceSingleByChannel(Hit, Character.Location, Character.Location + Right * FTP_ParkourMovementModel::WallProbeDistance, ECC_Visibility, QueryParams)
+				|| World->LineTraceSingleByChannel(Hit, Character.Location, Character.Location - Right * FTP_ParkourMovementModel::WallProbeDistance, ECC_Visibility, QueryParams))
+			{
+				Character.bWallRunning = true;
+				Character.WallNormal = Hit.Normal;
+				Character.JumpCount = 0;
+				Character.Velocity = FTP_ParkourMovementModel::GetWallRunDirection(Hit.Normal, Forward) * FTP_ParkourMovementModel::WallRunSpeed;
+			}
+		}
+		Character.WallRunCooldownLeft -= DeltaTime;
+
+		// PhysFalling: horizontal velocity only, with the falling friction and braking
+		const float VelocityZ = Character.Velocity.Z;
+		Character.Velocity.Z = 0.f;
+		CalcVelocity(Settings, Character.Velocity, GetFallingLateralAcceleration(Settings, Acceleration, Character.Velocity), MaxSpeed, Settings.FallingLateralFriction, Settings.BrakingDecelerationFalling, DeltaTime);
+		Character.Velocity.Z = VelocityZ;
+
+		// StartWallRun replaces the gravity scale and StopWallRun puts it back to 1
+		const float GravityScale = Character.bWallRunning ? FTP_ParkourMovementModel::WallRunGravityScale : Settings.GravityScale;
+		Character.Velocity.Z += World->GetGravityZ() * GravityScale * DeltaTime;
+	}
+	else
+	{
+		Character.Velocity.Z = 0.f;
+		CalcVelocity(Settings, Character.Velocity, Acceleration, MaxSpeed, Settings.GroundFriction, Settings.BrakingDecelerationWalking, DeltaTime);
+	}
+
+	// Move, sliding along anything that isn't a floor
+	FVector Delta = Character.Velocity * DeltaTime;
+	bool bSteppedUp = false;
+	for (int32 Iteration = 0; Iteration < 2 && !Delta.IsNearlyZero(); ++Iteration)
+	{
+		const FVector End = Character.Location + Delta;
+		if (!World->SweepSingleByChannel(Hit, Character.Location, End, FQuat::Identity, ECC_Pawn, Capsule, QueryParams))
+		{
+			Character.Location = End;
+			break;
+		}
+
+		// Step up onto low ledges while walking, like the movement component's StepUp: up, across, then the floor
+		// check below puts the character down on top
+		const float FeetZ = Character.Location.Z - HalfHeight;
+		if (!Character.bFalling && Hit.ImpactNormal.Z < Settings.WalkableFloorZ && Hit.ImpactPoint.Z - FeetZ <= Settings.MaxStepHeight)
+		{
+			const FVector Raised = Character.Location + FVector(0.f, 0.f, Settings.MaxStepHeight);
+			const FVector Across(Delta.X, Delta.Y, 0.f);
+			FHitResult StepHit;
+			if (!World->SweepSingleByChannel(StepHit, Character.Location, Raised, FQuat::Identity, ECC_Pawn, Capsule, QueryParams)
+				&& !World->SweepSingleByChannel(StepHit, Raised, Raised + Across, FQuat::Identity, ECC_Pawn, Capsule, QueryParams))
+			{
+				Character.Location = Raised + Across;
+				bSteppedUp = true;
+				break;
+			}
+		}
+
+		Character.Location = Hit.Location + Hit.Normal * 0.1f;
+		if (Character.bFalling && Hit.ImpactNormal.Z >= Settings.WalkableFloorZ)
+		{
+			// Landed
+			Character.bFalling = false;
+			Character.bWallRunning = false;
+			Character.JumpCount = 0;
+			Character.Velocity.Z = 0.f;
+			break;
+		}
+
+		Delta = FVector::VectorPlaneProject(Delta * (1.f - Hit.Time), Hit.ImpactNormal);
+		Character.Velocity = FVector::VectorPlaneProject(Character.Velocity, Hit.ImpactNormal);
+	}
+
+	// Walking characters stick to the floor, or start falling when it ends
+	if (!Character.bFalling)
+	{
+		// After a step up the floor is up to MaxStepHeight further down
+		const FVector FloorEnd = Character.Location - FVector(0.f, 0.f, Settings.MaxStepHeight * (bSteppedUp ? 2.f : 1.f) + 2.f);
+		if (World->SweepSingleByChannel(Hit, Character.Location, FloorEnd, FQuat::Identity, ECC_Pawn, Capsule, QueryParams) && Hit.ImpactNormal.Z >= Settings.WalkableFloorZ && !Hit.bStartPenetrating)
+		{
+			Character.Location = Hit.Location + FVector(0.f, 0.f, 0.1f);
+		}
+		else
+		{
+			Character.bFalling = true;
+		}
+	}
+}
+
+void FTP_SimEnvironment::StepProjectiles(const UWorld* World, const FTP_SimSettings& Settings, float DeltaTime)
+{
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TPSimulationProjectile), false);
+	const FCollisionShape Sphere = FCollisionShape::MakeSphere(Settings.ProjectileRadius);
+
+	for (int32 Index = Projectiles.Num() - 1; Index >= 0; --Index)
+	{
+		FTP_SimProjectile& Projectile = Projectiles[Index];
+		Projectile.LifeLeft -= DeltaTime;
+		Projectile.Velocity.Z += World->GetGravityZ() * Settings.ProjectileGravityScale * DeltaTime;
+		if (Settings.ProjectileMaxSpeed > 0.f)
+		{
+			Projectile.Velocity = Projectile.Velocity.GetClampedToMaxSize(Settings.ProjectileMaxSpeed);
+		}
+		const FVector Start = Projectile.Location;
+		const FVector End = Start + Projectile.Velocity * DeltaTime;
+
+		// The host world's geometry, then this environment's characters; the projectile explodes at the first one it touches
+		FHitResult Hit;
+		float HitTime = World->SweepSingleByChannel(Hit, Start, End, FQuat::Identity, ECC_Visibility, Sphere, QueryParams) ? Hit.Time : 2.f;
+
+		const float MoveLength = FVector::Dist(Start, End);
+		for (const FTP_SimCharacterState& Character : Characters)
+		{
+			// Capsule as a segment between its hemisphere centres, grown by the projectile's radius
+			const float Radius = Settings.CapsuleRadius + Settings.ProjectileRadius;
+			const float HalfSegment = FMath::Max((Character.bSliding ? FTP_ParkourMovementModel::SlideCapsuleHalfHeight : Settings.CapsuleHalfHeight) - Settings.CapsuleRadius, 0.f);
+			const FVector Offset(0.f, 0.f, HalfSegment);
+
+			FVector OnPath, OnCapsule;
+			FMath::SegmentDistToSegmentSafe(Start, End, Character.Location - Offset, Character.Location + Offset, OnPath, OnCapsule);
+			const float DistanceSquared = FVector::DistSquared(OnPath, OnCapsule);
+			if (DistanceSquared > FMath::Square(Radius))
+			{
+				continue;
+			}
+
+			// Back off from the closest approach to where the surface was first touched
+			const float Entry = MoveLength > UE_KINDA_SMALL_NUMBER
+				? (FVector::Dist(Start, OnPath) - FMath::Sqrt(FMath::Square(Radius) - DistanceSquared)) / MoveLength : 0.f;
+			HitTime = FMath::Min(HitTime, FMath::Max(Entry, 0.f));
+		}
+
+		if (HitTime <= 1.f)
+		{
+			// Like OnHit, the explosion is centred on the projectile
+			Explode(Settings, FMath::Lerp(Start, End, HitTime));
+			Projectiles.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		Projectile.Location = End;
+		if (Projectile.LifeLeft <= 0.f)
+		{
+			Projectiles.RemoveAtSwap(Index, 1, false);
+		}
+	}
+}
+
+void FTP_SimEnvironment::Explode(const FTP_SimSettings& Settings, const FVector& Origin)
+{
+	// Only this environment's characters; the host world's physics bodies are shared and never pushed
+	for (FTP_SimCharacterState& Character : Characters)
+	{
+		FVector Direction = Character.Location - Origin;
+		const float Distance = Direction.Size();
+		if (Distance >= Settings.ExplosionRadius)
+		{
+			continue;
+		}
+
+		Direction.Normalize();
+		Character.Velocity = Direction * Settings.ExplosionForce * (1.f - Distance / Settings.ExplosionRadius);
+		Character.bFalling = true;
+		if (Character.bSliding)
+		{
+			Character.bSliding = false;
+			Character.Location.Z += Settings.CapsuleHalfHeight - FTP_ParkourMovementModel::SlideCapsuleHalfHeight;
+		}
+		++Character.TimesHit;
+	}
+}
+
+void FTP_SimulationPool::Init(const UWorld* InWorld, int32 NumEnvironments, int32 NumCharacters)
+{
+	World = InWorld;
+	Settings.ReadFromDefaults(World);
+
+	SpawnLocations.Reset();
+	for (TActorIterator<APlayerStart> It(const_cast<UWorld*>(World)); It; ++It)
+	{
+		SpawnLocations.Add(It->GetActorLocation());
+	}
+	if (SpawnLocations.Num() == 0)
+	{
+		SpawnLocations.Add(FVector(0.f, 0.f, Settings.CapsuleHalfHeight + 100.f));
+	}
+
+	Environments.SetNum(NumEnvironments);
+	for (int32 Index = 0; Index < NumEnvironments; ++Index)
+	{
+		FTP_SimEnvironment& Environment = Environments[Index];
+		Environment.Characters.SetNum(NumCharacters);
+		Environment.Inputs.SetNum(NumCharacters);
+		Environment.Projectiles.Reserve(TPSimulation::MaxProjectilesPerEnvironment);
+		ResetEnvironment(Index);
+	}
+}
+
+void FTP_SimulationPool::ResetEnvironment(int32 Environment)
+{
+	FTP_SimEnvironment& Env = Environments[Environment];
+	for (int32 Index = 0; Index < Env.Characters.Num(); ++Index)
+	{
+		Env.Characters[Index] = FTP_SimCharacterState();
+		Env.Characters[Index].Location = SpawnLocations[Index % SpawnLocations.Num()];
+		Env.Characters[Index].bFalling = true;
+		Env.Inputs[Index] = FTP_SimInput();
+	}
+	Env.Projectiles.Reset();
+	Env.SimulatedSeconds = 0.0;
+}
+
+void FTP_SimulationPool::Step(int32 NumSteps)
+{
+	// Scene queries are read-only, environments share nothing else
+	ParallelFor(Environments.Num(), [this, NumSteps](int32 Index)
+	{
+		for (int32 StepIndex = 0; StepIndex < NumSteps; ++StepIndex)
+		{
+			Environments[Index].Step(World, Settings, FixedTimeStep);
+		}
+	});
+}
+
+void FTP_SimulationPool::SetInput(int32 Environment, int32 Character, const FTP_SimInput& Input)
+{
+	Environments[Environment].Inputs[Character] = Input;
+}
+
+const FTP_SimCharacterState& FTP_SimulationPool::Observe(int32 Environment, int32 Character) const
+{
+	return Environments[Environment].Characters[Character];
+}
+
+double FTP_SimulationPool::GetTotalSimulatedSeconds() const
+{
+	double Total = 0.0;
+	for (const FTP_SimEnvironment& Environment : Environments)
+	{
+		Total += Environment.SimulatedSeconds;
+	}
+	return Total;
+}
+
+void FTP_SimulationPool::RunBenchmark(const UWorld* World, int32 NumEnvironments, int32 NumCharacters, float Seconds)
+{
+	FTP_SimulationPool Pool;
+	Pool.Init(World, FMath::Max(NumEnvironments, 1), FMath::Max(NumCharacters, 1));
+
+	// Random inputs held for a quarter second at a time, stepped in the same chunks
+	constexpr int32 StepsPerDecision = 15;
+	const int32 NumDecisions = FMath::Max(FMath::CeilToInt32(Seconds / (FixedTimeStep * StepsPerDecision)), 1);
+
+	FRandomStream Random(42);
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 Decision = 0; Decision < NumDecisions; ++Decision)
+	{
+		for (int32 Env = 0; Env < Pool.GetNumEnvironments(); ++Env)
+		{
+			for (int32 Character = 0; Character < NumCharacters; ++Character)
+			{
+				FTP_SimInput Input;
+				Input.Move = FVector2f(Random.FRandRange(-1.f, 1.f), Random.FRandRange(0.f, 1.f));
+				Input.YawDelta = Random.FRandRange(-10.f, 10.f);
+				Input.bJump = Random.FRand() < 0.3f;
+				Input.bSprint = Random.FRand() < 0.5f;
+				Input.bSlide = Random.FRand() < 0.1f;
+				Input.bFire = Random.FRand() < 0.2f;
+				Pool.SetInput(Env, Character, Input);
+			}
+		}
+		Pool.Step(StepsPerDecision);
+	}
+	const double WallSeconds = FPlatformTime::Seconds() - StartTime;
+
+	const int32 NumCores = FMath::Min(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, Pool.GetNumEnvironments());
+	const double SimulatedSeconds = Pool.GetTotalSimulatedSeconds();
+	UE_LOG(LogTPSimulation, Display, TEXT("%d environments x %d characters, %.0f simulated s in %.2f wall s: %.0f simulated s per wall s, %.0f per core (%d cores)"),
+		Pool.GetNumEnvironments(), NumCharacters, SimulatedSeconds, WallSeconds, SimulatedSeconds / WallSeconds, SimulatedSeconds / WallSeconds / NumCores, NumCores);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPSimulationBenchCommand(
+	TEXT("TP.Sim.Bench"),
+	TEXT("Runs headless parkour simulations against this world's collision and logs throughput. Usage: TP.Sim.Bench [Environments=256] [Characters=4] [Seconds=60]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		FTP_SimulationPool::RunBenchmark(World,
+			Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 256,
+			Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 4,
+			Args.Num() > 2 ? FCString::Atof(*Args[2]) : 60.f);
+	}));
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPSimulation, Log, All);
+
+/** Input actions for one simulated character for one step, mirrors the character's input bindings */
+struct FTP_SimInput
+{
+	/** X right, Y forward, like the Move action */
+	FVector2f Move = FVector2f::ZeroVector;
+	float YawDelta = 0.f;
+	bool bJump = false;
+	bool bSprint = false;
+	bool bSlide = false;
+	bool bFire = false;
+};
+
+/** Observable state of one simulated character */
+struct FTP_SimCharacterState
+{
+	/** Capsule centre, as GetActorLocation */
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	float Yaw = 0.f;
+	int32 JumpCount = 0;
+	bool bFalling = false;
+	bool bSliding = false;
+	/** Speed cap while sliding, StartSlide's SlideSpeed */
+	float SlideMaxSpeed = 0.f;
+	bool bWallRunning = false;
+	FVector WallNormal = FVector::ZeroVector;
+	float WallRunCooldownLeft = 0.f;
+
+	/** Number of times this character was caught by an explosion */
+	int32 TimesHit = 0;
+
+	/** Previous step's buttons, actions fire on press like ETriggerEvent::Started */
+	bool bJumpHeld = false;
+	bool bFireHeld = false;
+};
+
+struct FTP_SimProjectile
+{
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	float LifeLeft = 0.f;
+};
+
+/**
+ * Settings the simulation shares with the real actors. The defaults here are only a fallback,
+ * FTP_SimulationPool::Init reads the real values from the class defaults with ReadFromDefaults.
+ */
+struct THIRDYEARPROJECT_API FTP_SimSettings
+{
+	// The character's capsule and UCharacterMovementComponent
+	float CapsuleRadius = 55.f;
+	float CapsuleHalfHeight = 96.f;
+	float MaxStepHeight = 45.f;
+	float WalkableFloorZ = 0.71f;
+	float MaxAcceleration = 2048.f;
+	float BrakingDecelerationWalking = 2048.f;
+	float BrakingDecelerationFalling = 0.f;
+	float GroundFriction = 0.5f;
+	float FallingLateralFriction = 0.f;
+	float BrakingFriction = 0.f;
+	float BrakingFrictionFactor = 0.2f;
+	bool bUseSeparateBrakingFriction = false;
+	float AirControl = 0.9f;
+	float AirControlBoostMultiplier = 2.f;
+	float AirControlBoostVelocityThreshold = 25.f;
+	float GravityScale = 1.f;
+	float WallRunCooldown = 0.3f;
+
+	/** The weapon's MuzzleOffset, rotated by the aim and added to the capsule centre as UTP_WeaponComponent::Fire does */
+	FVector MuzzleOffset = FVector(100.f, 0.f, 10.f);
+
+	// The weapon's projectile and its UProjectileMovementComponent
+	float ProjectileSpeed = 3000.f;
+	float ProjectileMaxSpeed = 3000.f;
+	float ProjectileGravityScale = 1.f;
+	float ProjectileRadius = 5.f;
+	float ProjectileLifeSpan = 3.f;
+
+	// UTP_ExplosionSubsystem
+	float ExplosionRadius = 500.f;
+	float ExplosionForce = 2000.f;
+
+	/** Reads everything above from World's default pawn class (or AThirdYearProjectCharacter), its first starting weapon and that weapon's projectile */
+	void ReadFromDefaults(const UWorld* World);
+};
+
+/**
+ * One independent simulation: a few characters and their projectiles.
+ * Moves with the same launch rules as AThirdYearProjectCharacter (FTP_ParkourMovementModel) and capsule sweeps against the
+ * host world's collision, but touches no actors, so any number of environments can step at once on worker threads.
+ *
+ * This is a hand-written approximation of UCharacterMovementComponent, not the component itself, and it will drift from
+ * the real character. Its settings come from the same class defaults (FTP_SimSettings) and its velocity follows
+ * CalcVelocity's friction, braking and air control, with the slide's speed cap and half-height capsule, step-up and the
+ * walkable floor angle. It has no floor perch/edge logic, slope speed handling, base movement, physics body interaction,
+ * network smoothing or the small velocity nudge in the character's Move. Anything learned or measured here has to be
+ * checked against the real character in game.
+ */
+struct THIRDYEARPROJECT_API FTP_SimEnvironment
+{
+	TArray<FTP_SimCharacterState> Characters;
+	TArray<FTP_SimInput> Inputs;
+	TArray<FTP_SimProjectile> Projectiles;
+	double SimulatedSeconds = 0.0;
+
+	/** Advances everything by one fixed step using the current Inputs */
+	void Step(const UWorld* World, const FTP_SimSettings& Settings, float DeltaTime);
+
+private:
+	void StepCharacter(const UWorld* World, const FTP_SimSettings& Settings, FTP_SimCharacterState& Character, const FTP_SimInput& Input, float DeltaTime);
+	void StepProjectiles(const UWorld* World, const FTP_SimSettings& Settings, float DeltaTime);
+	void Explode(const FTP_SimSettings& Settings, const FVector& Origin);
+};
+
+/**
+ * Runs many FTP_SimEnvironments headless inside one process and one loaded world, stepped in parallel at a fixed timestep.
+ * Environments only read the world's collision, nothing is rendered and no actors are spawned.
+ *
+ *   Pool.Init(World, 256, 4);
+ *   Pool.SetInput(Env, Character, Input);
+ *   Pool.Step(1);
+ *   const FTP_SimCharacterState& State = Pool.Observe(Env, Character);
+ */
+class THIRDYEARPROJECT_API FTP_SimulationPool
+{
+public:
+	static constexpr float FixedTimeStep = 1.f / 60.f;
+
+	/** Creates NumEnvironments environments of NumCharacters each, spawned at the world's player starts, and reads the settings from the class defaults */
+	void Init(const UWorld* InWorld, int32 NumEnvironments, int32 NumCharacters);
+
+	/** Steps every environment NumSteps fixed steps, environments in parallel */
+	void Step(int32 NumSteps);
+
+	void SetInput(int32 Environment, int32 Character, const FTP_SimInput& Input);
+	const FTP_SimCharacterState& Observe(int32 Environment, int32 Character) const;
+
+	/** Puts one environment's characters back on their spawn points */
+	void ResetEnvironment(int32 Environment);
+
+	int32 GetNumEnvironments() const { return Environments.Num(); }
+	const FTP_SimSettings& GetSettings() const { return Settings; }
+	const FTP_SimEnvironment& GetEnvironment(int32 Environment) const { return Environments[Environment]; }
+
+	/** Sum of simulated time over all environments */
+	double GetTotalSimulatedSeconds() const;
+
+	/** Steps NumEnvironments environments with random inputs for Seconds of simulated time and logs the throughput */
+	static void RunBenchmark(const UWorld* World, int32 NumEnvironments, int32 NumCharacters, float Seconds);
+
+private:
+	const UWorld* World = nullptr;
+	FTP_SimSettings Settings;
+	TArray<FTP_SimEnvironment> Environments;
+	TArray<FVector> SpawnLocations;
+};
@@ -14,6 +14,15 @@ void UTP_PickUpComponent::BeginPlay()
 
 	// Register our Overlap Event
 	OnComponentBeginOverlap.AddDynamic(this, &UTP_PickUpComponent::OnSphereBeginOverlap);
+
+	// Pickups don't change until they are collected, so on a server they replicate dormant and the replication graph
+	// keeps them out of its per-frame lists
+	AActor* Owner = GetOwner();
+	if (Owner != nullptr && Owner->HasAuthority() && GetNetMode() != NM_Standalone)
+	{
+		Owner->SetReplicates(true);
+		Owner->SetNetDormancy(DORM_DormantAll);
+	}
 }
 
 void UTP_PickUpComponent::OnSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
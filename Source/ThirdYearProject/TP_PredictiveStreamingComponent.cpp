@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_PredictiveStreamingComponent.h"
+#include "ThirdYearProjectCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+#include "WorldPartition/WorldPartitionRuntimeCell.h"
+#include "HAL/IConsoleManager.h"
+#include "EngineUtils.h"
+
+DEFINE_LOG_CATEGORY(LogTPStreaming);
+
+UTP_PredictiveStreamingComponent::UTP_PredictiveStreamingComponent()
+{
+	// The path only needs refreshing a few times a second, streaming itself updates at a lower rate than that
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickInterval = 0.1f;
+}
+
+void UTP_PredictiveStreamingComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UWorld* World = GetWorld();
+	if (World != nullptr && World->IsPartitionedWorld())
+	{
+		if (UWorldPartitionSubsystem* WorldPartitionSubsystem = World->GetSubsystem<UWorldPartitionSubsystem>())
+		{
+			WorldPartitionSubsystem->RegisterStreamingSourceProvider(this);
+			bRegistered = true;
+		}
+	}
+
+	// Sources are reused every tick, so names are only built once
+	PredictedSources.SetNum(NumSamples);
+	PredictedSampleTimes.Reset();
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		PredictedSources[Index].Name = FName(*FString::Printf(TEXT("%s_Predicted_%d"), *GetNameSafe(GetOwner()), Index));
+		PredictedSources[Index].TargetState = EStreamingSourceTargetState::Activated;
+		PredictedSources[Index].bBlockOnSlowLoading = false;
+		PredictedSources[Index].DebugColor = FColor::Orange;
+	}
+
+	SetComponentTickEnabled(bRegistered);
+}
+
+void UTP_PredictiveStreamingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bRegistered)
+	{
+		if (UWorldPartitionSubsystem* WorldPartitionSubsystem = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>())
+		{
+			WorldPartitionSubsystem->UnregisterStreamingSourceProvider(this);
+		}
+		bRegistered = false;
+	}
+
+	if (StreamingCheckCount > 0)
+	{
+		UE_LOG(LogTPStreaming, Log, TEXT("%s: %d streaming misses in %d checks"), *GetNameSafe(GetOwner()), StreamingMissCount, StreamingCheckCount);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UTP_PredictiveStreamingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const AThirdYearProjectCharacter* Character = Cast<AThirdYearProjectCharacter>(GetOwner());
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	UpdatePredictedPath(Character);
+	CheckStreamingMisses();
+}
+
+void UTP_PredictiveStreamingComponent::UpdatePredictedPath(const AThirdYearProjectCharacter* Character)
+{
+	const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+	const FVector Start = Character->GetActorLocation();
+	FVector Velocity = Movement->Velocity;
+
+	// Slides and sprints are held, so assume the character keeps at least its current max speed along the ground
+	const bool bAirborne = Movement->IsFalling();
+	if (!bAirborne && (Character->IsSliding() || Velocity.Size2D() > Movement->MaxWalkSpeed))
+	{
+		Velocity = Velocity.GetSafeNormal2D() * FMath::Max(Velocity.Size2D(), Movement->MaxWalkSpeed);
+	}
+
+	// While wall-running GravityScale is already lowered, so GetGravityZ covers that case as well
+	const float GravityZ = bAirborne ? Movement->GetGravityZ() : 0.0f;
+
+	if (Velocity.Size() < MinPredictionSpeed)
+	{
+		PredictedSampleTimes.Reset();
+		return;
+	}
+
+	PredictedSampleTimes.SetNum(PredictedSources.Num());
+	for (int32 Index = 0; Index < PredictedSources.Num(); ++Index)
+	{
+		const float Time = LookaheadSeconds * (Index + 1) / PredictedSources.Num();
+
+		// Ballistic arc; once it drops back to the launch height assume the character landed and carries on along the ground
+		FVector Location = Start + Velocity * Time;
+		Location.Z = Start.Z + Velocity.Z * Time + 0.5f * GravityZ * Time * Time;
+		if (bAirborne && Velocity.Z > 0.0f)
+		{
+			Location.Z = FMath::Max(Location.Z, Start.Z);
+		}
+
+		FWorldPartitionStreamingSource& Source = PredictedSources[Index];
+		Source.Location = Location;
+		Source.Rotation = Velocity.Rotation();
+
+		// Near samples are needed first, far ones are only a hint
+		const float Alpha = Time / LookaheadSeconds;
+		Source.Priority = Index == 0 ? EStreamingSourcePriority::Highest
+			: Alpha < 0.35f ? EStreamingSourcePriority::High
+			: Alpha < 0.7f ? EStreamingSourcePriority::Normal
+			: EStreamingSourcePriority::Low;
+
+		Source.Shapes.SetNum(1);
+		Source.Shapes[0].bUseGridLoadingRange = true;
+		Source.Shapes[0].LoadingRangeScale = LoadingRangeScale;
+
+		PredictedSampleTimes[Index] = Time;
+	}
+}
+
+void UTP_PredictiveStreamingComponent::CheckStreamingMisses()
+{
+	UWorldPartitionSubsystem* WorldPartitionSubsystem = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>();
+	if (WorldPartitionSubsystem == nullptr || PredictedSampleTimes.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FWorldPartitionStreamingQuerySource> QuerySources;
+	for (int32 Index = 0; Index < PredictedSampleTimes.Num() && PredictedSampleTimes[Index] <= MissHorizonSeconds; ++Index)
+	{
+		FWorldPartitionStreamingQuerySource& QuerySource = QuerySources.AddDefaulted_GetRef();
+		QuerySource.Location = PredictedSources[Index].Location;
+		QuerySource.bUseGridLoadingRange = false;
+		QuerySource.Radius = GetOwner()->GetSimpleCollisionRadius() * 4.0f;
+		QuerySource.bSpatialQuery = true;
+	}
+
+	if (QuerySources.Num() == 0)
+	{
+		return;
+	}
+
+	++StreamingCheckCount;
+	const bool bMissing = !WorldPartitionSubsystem->IsStreamingCompleted(EWorldPartitionRuntimeCellState::Activated, QuerySources, false);
+	if (bMissing)
+	{
+		++StreamingMissCount;
+
+		// Warn when a miss starts, not on every update it lasts
+		if (!bStreamingMissing)
+		{
+			UE_LOG(LogTPStreaming, Warning, TEXT("%s: cell needed within %.2fs is not activated yet (%d misses)"), *GetNameSafe(GetOwner()), MissHorizonSeconds, StreamingMissCount);
+		}
+	}
+	bStreamingMissing = bMissing;
+}
+
+bool UTP_PredictiveStreamingComponent::GetStreamingSources(TArray<FWorldPartitionStreamingSource>& OutStreamingSources) const
+{
+	if (!IsActive() || PredictedSampleTimes.Num() == 0)
+	{
+		return false;
+	}
+
+	OutStreamingSources.Append(PredictedSources.GetData(), PredictedSampleTimes.Num());
+	return true;
+}
+
+void UTP_PredictiveStreamingComponent::ResetStreamingStats()
+{
+	StreamingMissCount = 0;
+	StreamingCheckCount = 0;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPStreamingStatsCommand(
+	TEXT("TP.Streaming.Stats"),
+	TEXT("Prints predictive streaming misses for every character. Pass 'reset' to clear the counters."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const bool bReset = Args.Num() > 0 && Args[0] == TEXT("reset");
+		for (TActorIterator<AThirdYearProjectCharacter> It(World); It; ++It)
+		{
+			if (UTP_PredictiveStreamingComponent* Streaming = It->FindComponentByClass<UTP_PredictiveStreamingComponent>())
+			{
+				UE_LOG(LogTPStreaming, Display, TEXT("%s: %d streaming misses in %d checks"), *It->GetName(), Streaming->GetStreamingMissCount(), Streaming->GetStreamingCheckCount());
+				if (bReset)
+				{
+					Streaming->ResetStreamingStats();
+				}
+			}
+		}
+	}));
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "WorldPartition/WorldPartitionStreamingSource.h"
+#include "TP_PredictiveStreamingComponent.generated.h"
+
+class AThirdYearProjectCharacter;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPStreaming, Log, All);
+
+/**
+ * World Partition streaming source that follows where the owning character is going to be rather than where it is.
+ * The trajectory is projected from the current velocity and movement state (sprint, slide, wall-run, airborne)
+ * and every sample along it is requested as its own streaming source, with priority falling off over time.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class THIRDYEARPROJECT_API UTP_PredictiveStreamingComponent : public UActorComponent, public IWorldPartitionStreamingSourceProvider
+{
+	GENERATED_BODY()
+
+public:
+	UTP_PredictiveStreamingComponent();
+
+	/** How far ahead (in seconds) the trajectory is projected */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming)
+	float LookaheadSeconds = 3.0f;
+
+	/** Number of trajectory samples requested as streaming sources */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming, meta=(ClampMin="1", ClampMax="16"))
+	int32 NumSamples = 6;
+
+	/** Below this speed the character can't outrun the player controller's own source, so nothing is predicted */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming)
+	float MinPredictionSpeed = 700.0f;
+
+	/** Samples closer than this (in seconds) must already be loaded, otherwise it is counted as a streaming miss */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming)
+	float MissHorizonSeconds = 0.5f;
+
+	/** Scale applied to the grid loading range of each predicted source */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming)
+	float LoadingRangeScale = 0.5f;
+
+	/** Number of times a cell on the near part of the path was needed but not yet activated */
+	UFUNCTION(BlueprintCallable, Category=Streaming)
+	int32 GetStreamingMissCount() const { return StreamingMissCount; }
+
+	/** Number of streaming checks performed since BeginPlay */
+	UFUNCTION(BlueprintCallable, Category=Streaming)
+	int32 GetStreamingCheckCount() const { return StreamingCheckCount; }
+
+	/** Resets the miss counters, e.g. at the start of a scripted traversal */
+	UFUNCTION(BlueprintCallable, Category=Streaming)
+	void ResetStreamingStats();
+
+	// IWorldPartitionStreamingSourceProvider interface
+	virtual bool GetStreamingSources(TArray<FWorldPartitionStreamingSource>& OutStreamingSources) const override;
+	// End of IWorldPartitionStreamingSourceProvider interface
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	/** Rebuilds PredictedSources from the character's current movement state */
+	void UpdatePredictedPath(const AThirdYearProjectCharacter* Character);
+
+	/** Checks the near part of the predicted path against the current streaming state */
+	void CheckStreamingMisses();
+
+	/** Streaming sources handed to World Partition, rebuilt every tick */
+	TArray<FWorldPartitionStreamingSource> PredictedSources;
+
+	/** Time offset of each entry in PredictedSources */
+	TArray<float> PredictedSampleTimes;
+
+	int32 StreamingMissCount = 0;
+	int32 StreamingCheckCount = 0;
+	bool bRegistered = false;
+
+	/** Whether the last check missed, so a miss is only logged when it starts */
+	bool bStreamingMissing = false;
+};
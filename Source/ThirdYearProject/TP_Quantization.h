@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Small helpers for quantized, delta-compressed recordings (ghosts, replays) */
+namespace TPQuantization
+{
+	/** Largest number of bytes a 32 bit varint can take */
+	static constexpr int32 MaxVarIntBytes = 5;
+
+	/** Maps signed values to unsigned so small negative deltas stay small */
+	inline uint32 ZigZagEncode(int32 Value)
+	{
+		return (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+	}
+
+	inline int32 ZigZagDecode(uint32 Value)
+	{
+		return static_cast<int32>(Value >> 1) ^ -static_cast<int32>(Value & 1);
+	}
+
+	/** Writes a 7 bits per byte varint into Dest, which must have room for MaxVarIntBytes, returns the bytes written */
+	inline int32 WriteVarUInt(uint8* Dest, uint32 Value)
+	{
+		int32 NumBytes = 0;
+		while (Value >= 0x80)
+		{
+			Dest[NumBytes++] = static_cast<uint8>(Value | 0x80);
+			Value >>= 7;
+		}
+		Dest[NumBytes++] = static_cast<uint8>(Value);
+		return NumBytes;
+	}
+
+	/** Reads a varint starting at Offset and advances it; returns 0 and sets Offset past the end on truncated data */
+	inline uint32 ReadVarUInt(const uint8* Source, int32 SourceSize, int32& Offset)
+	{
+		uint32 Value = 0;
+		for (int32 Shift = 0; Shift < 35 && Offset < SourceSize; Shift += 7)
+		{
+			const uint8 Byte = Source[Offset++];
+			Value |= static_cast<uint32>(Byte & 0x7F) << Shift;
+			if ((Byte & 0x80) == 0)
+			{
+				return Value;
+			}
+		}
+		Offset = SourceSize + 1;
+		return 0;
+	}
+
+	inline void WriteVarUInt(TArray<uint8>& Out, uint32 Value)
+	{
+		uint8 Buffer[MaxVarIntBytes];
+		Out.Append(Buffer, WriteVarUInt(Buffer, Value));
+	}
+
+	inline void WriteVarInt(TArray<uint8>& Out, int32 Value)
+	{
+		WriteVarUInt(Out, ZigZagEncode(Value));
+	}
+
+	inline int32 ReadVarInt(const TArray<uint8>& In, int32& Offset)
+	{
+		return ZigZagDecode(ReadVarUInt(In.GetData(), In.Num(), Offset));
+	}
+
+	/** Positions are stored in whole centimetres (unreal units) */
+	inline FIntVector QuantizePosition(const FVector& Position)
+	{
+		return FIntVector(FMath::RoundToInt32(Position.X), FMath::RoundToInt32(Position.Y), FMath::RoundToInt32(Position.Z));
+	}
+
+	/** Shortest signed difference between two 16 bit quantized angles */
+	inline int32 AngleDelta16(uint16 From, uint16 To)
+	{
+		return static_cast<int16>(static_cast<uint16>(To - From));
+	}
+}
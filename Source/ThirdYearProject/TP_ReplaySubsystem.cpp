@@ -0,0 +1,647 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_ReplaySubsystem.h"
+#include "ThirdYearProject.h"
+#include "ThirdYearProjectCharacter.h"
+#include "ThirdYearProjectProjectile.h"
+#include "TP_ReplayViewer.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTPReplay);
+
+DECLARE_CYCLE_STAT(TEXT("Replay Record"), STAT_TPReplayRecord, STATGROUP_ThirdYearProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replay Bytes Used"), STAT_TPReplayBytesUsed, STATGROUP_ThirdYearProject);
+
+namespace TPReplay
+{
+	/** Relative frame and size varints in front of every frame */
+	constexpr int32 FrameHeaderBytes = TPQuantization::MaxVarIntBytes * 2;
+
+	/** State, three position varints, yaw varint, pitch */
+	constexpr int32 MaxCharacterFrameBytes = 1 + TPQuantization::MaxVarIntBytes * 4 + 1;
+
+	/** Source index (two varint bytes cover any sensible projectile count) and three position varints */
+	constexpr int32 MaxProjectileBytes = 2 + TPQuantization::MaxVarIntBytes * 3;
+
+	/** Explosions past this many in one sample are not recorded */
+	constexpr int32 MaxExplosionsPerFrame = 8;
+	constexpr int32 MaxExplosionBytes = TPQuantization::MaxVarIntBytes * 3;
+
+	/** Samples recorded by one tick at most, a hitch's backlog past this is dropped */
+	constexpr int32 MaxSamplesPerTick = 2;
+
+	/** Smallest chunk allowed, whatever the configured caps say */
+	constexpr int32 MinChunkBytes = 256;
+
+	static void WritePosition(TArray<uint8>& Out, const FIntVector& Position)
+	{
+		TPQuantization::WriteVarInt(Out, Position.X);
+		TPQuantization::WriteVarInt(Out, Position.Y);
+		TPQuantization::WriteVarInt(Out, Position.Z);
+	}
+
+	/** ReadVarInt on a raw frame */
+	static int32 ReadInt(const uint8* Data, int32 Size, int32& Offset)
+	{
+		return TPQuantization::ZigZagDecode(TPQuantization::ReadVarUInt(Data, Size, Offset));
+	}
+
+	static FIntVector ReadPosition(const uint8* Data, int32 Size, int32& Offset)
+	{
+		FIntVector Position;
+		Position.X = ReadInt(Data, Size, Offset);
+		Position.Y = ReadInt(Data, Size, Offset);
+		Position.Z = ReadInt(Data, Size, Offset);
+		return Position;
+	}
+}
+
+void FTP_ReplayRing::Init(int32 InChunkSize, int32 InNumChunks, uint32 InFramesPerKeyframe)
+{
+	ChunkSize = InChunkSize;
+	FramesPerKeyframe = FMath::Max<uint32>(InFramesPerKeyframe, 1);
+	Buffer.SetNumUninitialized(InChunkSize * InNumChunks);
+	Chunks.SetNum(InNumChunks);
+	Reset();
+}
+
+void FTP_ReplayRing::Reset()
+{
+	for (FChunk& Chunk : Chunks)
+	{
+		Chunk = FChunk();
+	}
+	Head = INDEX_NONE;
+}
+
+bool FTP_ReplayRing::NeedsKeyframe(uint32 Frame, int32 Size) const
+{
+	if (Head == INDEX_NONE)
+	{
+		return true;
+	}
+
+	const FChunk& Chunk = Chunks[Head];
+	return Frame - Chunk.StartFrame >= FramesPerKeyframe || Chunk.UsedBytes + TPReplay::FrameHeaderBytes + Size > ChunkSize;
+}
+
+bool FTP_ReplayRing::Write(uint32 Frame, const uint8* Data, int32 Size, bool bKeyframe)
+{
+	if (Size + TPReplay::FrameHeaderBytes > ChunkSize || (!bKeyframe && NeedsKeyframe(Frame, Size)))
+	{
+		return false;
+	}
+
+	if (bKeyframe)
+	{
+		// Overwrites the oldest chunk once the ring has wrapped
+		Head = (Head + 1) % Chunks.Num();
+		Chunks[Head].StartFrame = Frame;
+		Chunks[Head].UsedBytes = 0;
+		Chunks[Head].bValid = true;
+	}
+
+	FChunk& Chunk = Chunks[Head];
+	uint8* Dest = Buffer.GetData() + Head * ChunkSize + Chunk.UsedBytes;
+	int32 Written = TPQuantization::WriteVarUInt(Dest, Frame - Chunk.StartFrame);
+	Written += TPQuantization::WriteVarUInt(Dest + Written, static_cast<uint32>(Size));
+	FMemory::Memcpy(Dest + Written, Data, Size);
+	Chunk.UsedBytes += Written + Size;
+	return true;
+}
+
+bool FTP_ReplayRing::GetOldestFrame(uint32& OutFrame) const
+{
+	if (Head == INDEX_NONE)
+	{
+		return false;
+	}
+
+	for (int32 Offset = 1; Offset <= Chunks.Num(); ++Offset)
+	{
+		const FChunk& Chunk = Chunks[(Head + Offset) % Chunks.Num()];
+		if (Chunk.bValid)
+		{
+			OutFrame = Chunk.StartFrame;
+			return true;
+		}
+	}
+	return false;
+}
+
+int32 FTP_ReplayRing::GetUsedBytes() const
+{
+	int32 UsedBytes = 0;
+	for (const FChunk& Chunk : Chunks)
+	{
+		UsedBytes += Chunk.bValid ? Chunk.UsedBytes : 0;
+	}
+	return UsedBytes;
+}
+
+bool UTP_ReplaySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTP_ReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	using namespace TPReplay;
+
+	// Everything recording touches is allocated here, the caps below are the whole budget
+	SampleRate = FMath::Clamp(SampleRate, 1, 60);
+	const int32 NumChunks = FMath::Max(ChunksPerBuffer, 2);
+	const uint32 FramesPerKeyframe = FMath::Max(FMath::RoundToInt32(KeyframeInterval * SampleRate), 1);
+
+	CharacterSlots.SetNum(FMath::Max(MaxRecordedCharacters, 0));
+	for (FCharacterSlot& Slot : CharacterSlots)
+	{
+		Slot.Ring.Init(FMath::Max(MaxBytesPerCharacter / NumChunks, MinChunkBytes), NumChunks, FramesPerKeyframe);
+	}
+	WorldRing.Init(FMath::Max(MaxWorldBytes / NumChunks, MinChunkBytes), NumChunks, FramesPerKeyframe);
+
+	const int32 FixedWorldBytes = FrameHeaderBytes + TPQuantization::MaxVarIntBytes * 2 + MaxExplosionsPerFrame * MaxExplosionBytes;
+	MaxProjectilesPerFrame = FMath::Max((WorldRing.GetChunkSize() - FixedWorldBytes) / MaxProjectileBytes, 0);
+
+	Projectiles.Reserve(MaxProjectilesPerFrame);
+	PendingExplosions.Reserve(MaxExplosionsPerFrame);
+	ProjectileTracks.Reserve(MaxProjectilesPerFrame);
+	NextProjectileTracks.Reserve(MaxProjectilesPerFrame);
+	Scratch.Reserve(WorldRing.GetChunkSize());
+
+	UE_LOG(LogTPReplay, Log, TEXT("Replay buffer: %d character rings of %d KB, %d KB for projectiles and explosions, %d KB total"),
+		CharacterSlots.Num(), MaxBytesPerCharacter / 1024, MaxWorldBytes / 1024, GetAllocatedBytes() / 1024);
+}
+
+void UTP_ReplaySubsystem::RegisterCharacter(AThirdYearProjectCharacter* Character)
+{
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	// Prefer a slot that was never used, then one whose character is gone
+	FCharacterSlot* FreeSlot = nullptr;
+	for (FCharacterSlot& Slot : CharacterSlots)
+	{
+		if (Slot.Character.Get() == Character)
+		{
+			return;
+		}
+
+		uint32 OldestFrame = 0;
+		const bool bEmpty = !Slot.Ring.GetOldestFrame(OldestFrame);
+		if (!Slot.Character.IsValid() && (FreeSlot == nullptr || bEmpty))
+		{
+			FreeSlot = &Slot;
+		}
+	}
+
+	if (FreeSlot == nullptr)
+	{
+		UE_CLOG(!bWarnedNoSlot, LogTPReplay, Warning, TEXT("All %d replay slots are in use, %s is not recorded"), CharacterSlots.Num(), *Character->GetName());
+		bWarnedNoSlot = true;
+		return;
+	}
+
+	FreeSlot->Character = Character;
+	FreeSlot->Ring.Reset();
+}
+
+void UTP_ReplaySubsystem::RegisterProjectile(AThirdYearProjectProjectile* Projectile)
+{
+	if (Projectile == nullptr)
+	{
+		return;
+	}
+
+	// Never grows past what Init reserved; make room from destroyed ones first
+	if (Projectiles.Num() >= MaxProjectilesPerFrame)
+	{
+		Projectiles.RemoveAllSwap([](const TWeakObjectPtr<AThirdYearProjectProjectile>& Tracked) { return !Tracked.IsValid(); }, false);
+	}
+	if (Projectiles.Num() >= MaxProjectilesPerFrame)
+	{
+		UE_CLOG(!bWarnedNoProjectileRoom, LogTPReplay, Warning, TEXT("Replay is tracking %d projectiles already, %s is not recorded"), Projectiles.Num(), *Projectile->GetName());
+		bWarnedNoProjectileRoom = true;
+		return;
+	}
+
+	Projectiles.Add(Projectile);
+}
+
+void UTP_ReplaySubsystem::RecordExplosion(const FVector& Location)
+{
+	if (PendingExplosions.Num() < TPReplay::MaxExplosionsPerFrame)
+	{
+		PendingExplosions.Add(Location);
+	}
+}
+
+void UTP_ReplaySubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPReplayRecord);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	const float SampleInterval = 1.f / SampleRate;
+	TimeSinceLastSample += DeltaTime;
+
+	// Frame rates just under the sample rate catch up with an extra sample. After a hitch the missed samples would all
+	// record the same state in one frame, so the rest of the backlog is dropped instead
+	for (int32 NumSamples = 0; TimeSinceLastSample >= SampleInterval && NumSamples < TPReplay::MaxSamplesPerTick; ++NumSamples)
+	{
+		TimeSinceLastSample -= SampleInterval;
+		RecordSample();
+	}
+	TimeSinceLastSample = FMath::Fmod(TimeSinceLastSample, SampleInterval);
+
+	const double RecordMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	TotalRecordMs += RecordMs;
+	MaxRecordMs = FMath::Max(MaxRecordMs, RecordMs);
+	++NumTicks;
+}
+
+TStatId UTP_ReplaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTP_ReplaySubsystem, STATGROUP_Tickables);
+}
+
+void UTP_ReplaySubsystem::RecordSample()
+{
+	for (FCharacterSlot& Slot : CharacterSlots)
+	{
+		RecordCharacter(Slot);
+	}
+	RecordWorld();
+	++CurrentFrame;
+
+	SET_DWORD_STAT(STAT_TPReplayBytesUsed, GetUsedBytes());
+}
+
+void UTP_ReplaySubsystem::RecordCharacter(FCharacterSlot& Slot)
+{
+	const AThirdYearProjectCharacter* Character = Slot.Character.Get();
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	// Same state bits as ghost recordings
+	uint8 State = static_cast<uint8>(FMath::Min(Character->GetJumpCount(), 3) << TPGhostState::JumpCountShift);
+	State |= Character->IsSliding() ? TPGhostState::Sliding : 0;
+	State |= Character->IsWallRunning() ? TPGhostState::WallRunning : 0;
+	State |= Character->GetCharacterMovement()->IsFalling() ? TPGhostState::Airborne : 0;
+
+	const FIntVector Position = TPQuantization::QuantizePosition(Character->GetActorLocation());
+	const FRotator ViewRotation = Character->GetControlRotation();
+	const uint16 Yaw = FRotator::CompressAxisToShort(ViewRotation.Yaw);
+	const uint8 Pitch = FRotator::CompressAxisToByte(ViewRotation.Pitch);
+
+	EncodeCharacter(Slot, State, Position, Yaw, Pitch, false);
+	const bool bKeyframe = Slot.Ring.NeedsKeyframe(CurrentFrame, Scratch.Num());
+	if (bKeyframe)
+	{
+		EncodeCharacter(Slot, State, Position, Yaw, Pitch, true);
+	}
+
+	if (Slot.Ring.Write(CurrentFrame, Scratch.GetData(), Scratch.Num(), bKeyframe))
+	{
+		Slot.PreviousPosition = bKeyframe ? Position : Slot.LastPosition;
+		Slot.LastPosition = Position;
+		Slot.LastYaw = Yaw;
+	}
+}
+
+void UTP_ReplaySubsystem::EncodeCharacter(const FCharacterSlot& Slot, uint8 State, const FIntVector& Position, uint16 Yaw, uint8 Pitch, bool bKeyframe)
+{
+	Scratch.Reset();
+	Scratch.Add(State);
+	if (bKeyframe)
+	{
+		TPReplay::WritePosition(Scratch, Position);
+		TPQuantization::WriteVarUInt(Scratch, Yaw);
+	}
+	else
+	{
+		TPReplay::WritePosition(Scratch, Position - (Slot.LastPosition + (Slot.LastPosition - Slot.PreviousPosition)));
+		TPQuantization::WriteVarInt(Scratch, TPQuantization::AngleDelta16(Slot.LastYaw, Yaw));
+	}
+	Scratch.Add(Pitch);
+}
+
+void UTP_ReplaySubsystem::RecordWorld()
+{
+	// Destroyed projectiles drop out here; parked ones are waiting on a checkpoint and aren't in play
+	Projectiles.RemoveAllSwap([](const TWeakObjectPtr<AThirdYearProjectProjectile>& Projectile) { return !Projectile.IsValid(); }, false);
+
+	NextProjectileTracks.Reset();
+	for (const TWeakObjectPtr<AThirdYearProjectProjectile>& Projectile : Projectiles)
+	{
+		if (!Projectile->IsParked() && NextProjectileTracks.Num() < MaxProjectilesPerFrame)
+		{
+			FProjectileTrack& Track = NextProjectileTracks.AddDefaulted_GetRef();
+			Track.Projectile = Projectile.Get();
+			Track.LastPosition = TPQuantization::QuantizePosition(Projectile->GetActorLocation());
+		}
+	}
+
+	EncodeWorld(false);
+	const bool bKeyframe = WorldRing.NeedsKeyframe(CurrentFrame, Scratch.Num());
+	if (bKeyframe)
+	{
+		EncodeWorld(true);
+	}
+
+	if (WorldRing.Write(CurrentFrame, Scratch.GetData(), Scratch.Num(), bKeyframe))
+	{
+		Swap(ProjectileTracks, NextProjectileTracks);
+	}
+	PendingExplosions.Reset();
+}
+
+void UTP_ReplaySubsystem::EncodeWorld(bool bKeyframe)
+{
+	// Explosions are events, written once with absolute positions
+	Scratch.Reset();
+	TPQuantization::WriteVarUInt(Scratch, PendingExplosions.Num());
+	for (const FVector& Explosion : PendingExplosions)
+	{
+		TPReplay::WritePosition(Scratch, TPQuantization::QuantizePosition(Explosion));
+	}
+
+	// Projectiles still in flight reference last frame's index and store a residual, new ones (and keyframes) are absolute
+	TPQuantization::WriteVarUInt(Scratch, NextProjectileTracks.Num());
+	for (FProjectileTrack& Track : NextProjectileTracks)
+	{
+		const FIntVector Position = Track.LastPosition;
+		const int32 Source = bKeyframe ? INDEX_NONE : ProjectileTracks.IndexOfByPredicate([&Track](const FProjectileTrack& Previous) { return Previous.Projectile == Track.Projectile; });
+
+		TPQuantization::WriteVarUInt(Scratch, static_cast<uint32>(Source + 1));
+		if (Source == INDEX_NONE)
+		{
+			TPReplay::WritePosition(Scratch, Position);
+			Track.PreviousPosition = Position;
+		}
+		else
+		{
+			const FProjectileTrack& Previous = ProjectileTracks[Source];
+			TPReplay::WritePosition(Scratch, Position - (Previous.LastPosition + (Previous.LastPosition - Previous.PreviousPosition)));
+			Track.PreviousPosition = Previous.LastPosition;
+		}
+	}
+}
+
+bool UTP_ReplaySubsystem::BuildSnapshot(float Seconds, FTP_ReplaySnapshot& OutSnapshot) const
+{
+	using namespace TPReplay;
+
+	uint32 OldestFrame = 0;
+	if (CurrentFrame == 0 || !WorldRing.GetOldestFrame(OldestFrame))
+	{
+		return false;
+	}
+
+	const uint32 LastFrame = CurrentFrame - 1;
+	const uint32 RequestedFrames = static_cast<uint32>(FMath::Max(FMath::CeilToInt32(Seconds * SampleRate), 1));
+	const uint32 FirstFrame = FMath::Max(OldestFrame, LastFrame + 1 > RequestedFrames ? LastFrame + 1 - RequestedFrames : 0u);
+
+	OutSnapshot = FTP_ReplaySnapshot();
+	OutSnapshot.SampleInterval = 1.f / SampleRate;
+	OutSnapshot.NumFrames = static_cast<int32>(LastFrame - FirstFrame + 1);
+
+	// Projectiles and explosions
+	TArray<FIntVector> LastPositions, PreviousPositions, NextLastPositions, NextPreviousPositions;
+	uint32 LastDecodedFrame = 0;
+	WorldRing.ForEachFrame(FirstFrame, [&](uint32 Frame, const uint8* Data, int32 Size, bool bKeyframe)
+	{
+		int32 Offset = 0;
+		const bool bInRange = Frame >= FirstFrame && Frame <= LastFrame;
+		const int32 FrameIndex = static_cast<int32>(Frame - FirstFrame);
+
+		const int32 NumExplosions = static_cast<int32>(TPQuantization::ReadVarUInt(Data, Size, Offset));
+		for (int32 Index = 0; Index < NumExplosions && Offset <= Size; ++Index)
+		{
+			const FIntVector Position = ReadPosition(Data, Size, Offset);
+			if (bInRange)
+			{
+				FTP_ReplaySnapshot::FExplosion& Explosion = OutSnapshot.Explosions.AddDefaulted_GetRef();
+				Explosion.Time = FrameIndex * OutSnapshot.SampleInterval;
+				Explosion.Location = FVector3f(Position.X, Position.Y, Position.Z);
+			}
+		}
+
+		// Frames that failed to record show no projectiles
+		if (bInRange)
+		{
+			while (OutSnapshot.ProjectileStarts.Num() <= FrameIndex)
+			{
+				OutSnapshot.ProjectileStarts.Add(OutSnapshot.ProjectileLocations.Num());
+			}
+		}
+		const bool bContiguous = Frame == LastDecodedFrame + 1 && Frame > FirstFrame;
+
+		const int32 NumProjectiles = static_cast<int32>(TPQuantization::ReadVarUInt(Data, Size, Offset));
+		NextLastPositions.Reset();
+		NextPreviousPositions.Reset();
+		for (int32 Index = 0; Index < NumProjectiles && Offset <= Size; ++Index)
+		{
+			const int32 Source = static_cast<int32>(TPQuantization::ReadVarUInt(Data, Size, Offset)) - 1;
+			const bool bTracked = !bKeyframe && LastPositions.IsValidIndex(Source);
+
+			FIntVector Position = ReadPosition(Data, Size, Offset);
+			if (bTracked)
+			{
+				Position += LastPositions[Source] + (LastPositions[Source] - PreviousPositions[Source]);
+			}
+			NextLastPositions.Add(Position);
+			NextPreviousPositions.Add(bTracked ? LastPositions[Source] : Position);
+
+			if (bInRange)
+			{
+				OutSnapshot.ProjectileLocations.Add(FVector3f(Position.X, Position.Y, Position.Z));
+				OutSnapshot.ProjectileSources.Add(bTracked && bContiguous ? Source : INDEX_NONE);
+			}
+		}
+
+		Swap(LastPositions, NextLastPositions);
+		Swap(PreviousPositions, NextPreviousPositions);
+		LastDecodedFrame = Frame;
+	});
+	while (OutSnapshot.ProjectileStarts.Num() <= OutSnapshot.NumFrames)
+	{
+		OutSnapshot.ProjectileStarts.Add(OutSnapshot.ProjectileLocations.Num());
+	}
+
+	// Characters
+	for (const FCharacterSlot& Slot : CharacterSlots)
+	{
+		FTP_ReplaySnapshot::FCharacterTrack Track;
+		Track.Character = Slot.Character;
+		Track.Samples.SetNum(OutSnapshot.NumFrames);
+		Track.Present.Init(false, OutSnapshot.NumFrames);
+
+		FIntVector Last = FIntVector::ZeroValue;
+		FIntVector Previous = FIntVector::ZeroValue;
+		uint16 Yaw = 0;
+		bool bAnyPresent = false;
+		Slot.Ring.ForEachFrame(FirstFrame, [&](uint32 Frame, const uint8* Data, int32 Size, bool bKeyframe)
+		{
+			int32 Offset = 0;
+			if (Size < 2)
+			{
+				return;
+			}
+
+			const uint8 State = Data[Offset++];
+			FIntVector Position = ReadPosition(Data, Size, Offset);
+			if (bKeyframe)
+			{
+				Yaw = static_cast<uint16>(TPQuantization::ReadVarUInt(Data, Size, Offset));
+				Previous = Position;
+			}
+			else
+			{
+				Position += Last + (Last - Previous);
+				Yaw = static_cast<uint16>(Yaw + ReadInt(Data, Size, Offset));
+				Previous = Last;
+			}
+			Last = Position;
+			const uint8 Pitch = Offset < Size ? Data[Offset] : 0;
+
+			if (Frame >= FirstFrame && Frame <= LastFrame)
+			{
+				const int32 FrameIndex = static_cast<int32>(Frame - FirstFrame);
+				FTP_GhostSample& Sample = Track.Samples[FrameIndex];
+				Sample.Location = FVector3f(Position.X, Position.Y, Position.Z);
+				Sample.Yaw = FRotator::DecompressAxisFromShort(Yaw);
+				Sample.Pitch = FRotator::NormalizeAxis(FRotator::DecompressAxisFromByte(Pitch));
+				Sample.State = State;
+				Track.Present[FrameIndex] = true;
+				bAnyPresent = true;
+			}
+		});
+
+		if (!bAnyPresent)
+		{
+			continue;
+		}
+
+		// Gaps hold the nearest recorded sample so interpolation never pulls towards the origin
+		int32 FirstPresent = 0;
+		while (!Track.Present[FirstPresent])
+		{
+			++FirstPresent;
+		}
+		for (int32 Index = 0; Index < OutSnapshot.NumFrames; ++Index)
+		{
+			if (!Track.Present[Index])
+			{
+				Track.Samples[Index] = Track.Samples[Index < FirstPresent ? FirstPresent : Index - 1];
+			}
+		}
+
+		OutSnapshot.Characters.Add(MoveTemp(Track));
+	}
+
+	return OutSnapshot.NumFrames > 0;
+}
+
+ATP_ReplayViewer* UTP_ReplaySubsystem::PlayReplay(APlayerController* Viewer, float Seconds, const AThirdYearProjectCharacter* Focus)
+{
+	FTP_ReplaySnapshot Snapshot;
+	if (Viewer == nullptr || !BuildSnapshot(Seconds, Snapshot))
+	{
+		return nullptr;
+	}
+
+	const int32 FocusTrack = Snapshot.Characters.IndexOfByPredicate([Focus](const FTP_ReplaySnapshot::FCharacterTrack& Track)
+	{
+		return Focus != nullptr && Track.Character.Get() == Focus;
+	});
+
+	ATP_ReplayViewer* ReplayViewer = GetWorld()->SpawnActor<ATP_ReplayViewer>();
+	if (ReplayViewer != nullptr)
+	{
+		UE_LOG(LogTPReplay, Log, TEXT("Replaying %.1fs: %d characters, %d projectile samples, %d explosions"),
+			Snapshot.GetDuration(), Snapshot.Characters.Num(), Snapshot.ProjectileLocations.Num(), Snapshot.Explosions.Num());
+		ReplayViewer->StartPlayback(MoveTemp(Snapshot), Viewer, FocusTrack);
+	}
+	return ReplayViewer;
+}
+
+int32 UTP_ReplaySubsystem::GetAllocatedBytes() const
+{
+	int32 AllocatedBytes = WorldRing.GetAllocatedBytes() + Scratch.GetAllocatedSize() + CharacterSlots.GetAllocatedSize();
+	AllocatedBytes += Projectiles.GetAllocatedSize() + PendingExplosions.GetAllocatedSize() + ProjectileTracks.GetAllocatedSize() + NextProjectileTracks.GetAllocatedSize();
+	for (const FCharacterSlot& Slot : CharacterSlots)
+	{
+		AllocatedBytes += Slot.Ring.GetAllocatedBytes();
+	}
+	return AllocatedBytes;
+}
+
+int32 UTP_ReplaySubsystem::GetUsedBytes() const
+{
+	int32 UsedBytes = WorldRing.GetUsedBytes();
+	for (const FCharacterSlot& Slot : CharacterSlots)
+	{
+		UsedBytes += Slot.Ring.GetUsedBytes();
+	}
+	return UsedBytes;
+}
+
+float UTP_ReplaySubsystem::GetBufferedSeconds() const
+{
+	uint32 OldestFrame = 0;
+	return WorldRing.GetOldestFrame(OldestFrame) ? static_cast<float>(CurrentFrame - OldestFrame) / SampleRate : 0.f;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPReplayPlayCommand(
+	TEXT("TP.Replay.Play"),
+	TEXT("Replays the last seconds of play from the first player's point of view. Usage: TP.Replay.Play [Seconds=15]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UTP_ReplaySubsystem* Replay = World->GetSubsystem<UTP_ReplaySubsystem>();
+		APlayerController* PlayerController = World->GetFirstPlayerController();
+		if (Replay == nullptr || PlayerController == nullptr)
+		{
+			return;
+		}
+
+		const float Seconds = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 15.f;
+		if (Replay->PlayReplay(PlayerController, Seconds, Cast<AThirdYearProjectCharacter>(PlayerController->GetPawn())) == nullptr)
+		{
+			UE_LOG(LogTPReplay, Warning, TEXT("Nothing recorded yet"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GTPReplayStopCommand(
+	TEXT("TP.Replay.Stop"),
+	TEXT("Stops every running replay"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		for (TActorIterator<ATP_ReplayViewer> It(World); It; ++It)
+		{
+			It->StopPlayback();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GTPReplayStatsCommand(
+	TEXT("TP.Replay.Stats"),
+	TEXT("Logs replay buffer memory, history length and recording cost"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UTP_ReplaySubsystem* Replay = World->GetSubsystem<UTP_ReplaySubsystem>())
+		{
+			UE_LOG(LogTPReplay, Display, TEXT("Replay buffer: %.1f s buffered, %d / %d KB used, recording %.4f ms per frame on average, %.3f ms worst"),
+				Replay->GetBufferedSeconds(), Replay->GetUsedBytes() / 1024, Replay->GetAllocatedBytes() / 1024,
+				Replay->GetAverageRecordMs(), Replay->GetMaxRecordMs());
+		}
+	}));
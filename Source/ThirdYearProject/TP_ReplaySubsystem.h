@@ -0,0 +1,272 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TP_GhostRecorderComponent.h"
+#include "TP_Quantization.h"
+#include "TP_ReplaySubsystem.generated.h"
+
+class AThirdYearProjectCharacter;
+class AThirdYearProjectProjectile;
+class APlayerController;
+class ATP_ReplayViewer;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPReplay, Log, All);
+
+/**
+ * Fixed-size ring of encoded frames, split into equal chunks that each start with a keyframe.
+ * All memory is allocated by Init. When the ring is full the oldest chunk is overwritten, so history is dropped one
+ * keyframe at a time and decoding can always start at the oldest chunk still stored.
+ */
+struct FTP_ReplayRing
+{
+	void Init(int32 InChunkSize, int32 InNumChunks, uint32 InFramesPerKeyframe);
+	void Reset();
+
+	/** True when a frame of Size bytes can't go into the current chunk: nothing stored yet, the keyframe is due, or it's full */
+	bool NeedsKeyframe(uint32 Frame, int32 Size) const;
+
+	/** Stores an encoded frame, a keyframe starts a new chunk; returns false if it is larger than a chunk */
+	bool Write(uint32 Frame, const uint8* Data, int32 Size, bool bKeyframe);
+
+	/** Calls Visitor(Frame, Data, Size, bKeyframe) oldest first, from the last keyframe at or before FirstFrame */
+	template<typename VisitorType>
+	void ForEachFrame(uint32 FirstFrame, VisitorType&& Visitor) const;
+
+	/** Frame the oldest stored chunk starts at, false when the ring is empty */
+	bool GetOldestFrame(uint32& OutFrame) const;
+
+	int32 GetAllocatedBytes() const { return Buffer.Num(); }
+	int32 GetUsedBytes() const;
+	int32 GetChunkSize() const { return ChunkSize; }
+
+private:
+	struct FChunk
+	{
+		uint32 StartFrame = 0;
+		int32 UsedBytes = 0;
+		bool bValid = false;
+	};
+
+	TArray<uint8> Buffer;
+	TArray<FChunk> Chunks;
+	int32 ChunkSize = 0;
+	uint32 FramesPerKeyframe = 1;
+
+	/** Chunk being written */
+	int32 Head = INDEX_NONE;
+};
+
+template<typename VisitorType>
+void FTP_ReplayRing::ForEachFrame(uint32 FirstFrame, VisitorType&& Visitor) const
+{
+	if (Head == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Oldest valid chunk, then skip forward to the last one that still starts at or before FirstFrame
+	int32 Start = (Head + 1) % Chunks.Num();
+	while (!Chunks[Start].bValid)
+	{
+		Start = (Start + 1) % Chunks.Num();
+	}
+	for (int32 Next = (Start + 1) % Chunks.Num(); Start != Head && Chunks[Next].StartFrame <= FirstFrame; Next = (Next + 1) % Chunks.Num())
+	{
+		Start = Next;
+	}
+
+	for (int32 ChunkIndex = Start; ; ChunkIndex = (ChunkIndex + 1) % Chunks.Num())
+	{
+		const FChunk& Chunk = Chunks[ChunkIndex];
+		const uint8* ChunkData = Buffer.GetData() + ChunkIndex * ChunkSize;
+
+		int32 Offset = 0;
+		bool bKeyframe = true;
+		while (Offset < Chunk.UsedBytes)
+		{
+			const uint32 Frame = Chunk.StartFrame + TPQuantization::ReadVarUInt(ChunkData, Chunk.UsedBytes, Offset);
+			const int32 Size = static_cast<int32>(TPQuantization::ReadVarUInt(ChunkData, Chunk.UsedBytes, Offset));
+			if (Offset + Size > Chunk.UsedBytes)
+			{
+				break;
+			}
+			Visitor(Frame, ChunkData + Offset, Size, bKeyframe);
+			Offset += Size;
+			bKeyframe = false;
+		}
+
+		if (ChunkIndex == Head)
+		{
+			break;
+		}
+	}
+}
+
+/** The last few seconds decoded for playback, see UTP_ReplaySubsystem::BuildSnapshot */
+struct FTP_ReplaySnapshot
+{
+	float SampleInterval = 0.05f;
+	int32 NumFrames = 0;
+
+	struct FCharacterTrack
+	{
+		TWeakObjectPtr<const AThirdYearProjectCharacter> Character;
+
+		/** One sample per frame, frames where the character wasn't recorded repeat its nearest sample */
+		TArray<FTP_GhostSample> Samples;
+		TBitArray<> Present;
+	};
+	TArray<FCharacterTrack> Characters;
+
+	/** Frame N's projectiles are ProjectileLocations[ProjectileStarts[N] .. ProjectileStarts[N + 1]) */
+	TArray<int32> ProjectileStarts;
+	TArray<FVector3f> ProjectileLocations;
+
+	/** Index of the same projectile in the previous frame, INDEX_NONE when it was just fired */
+	TArray<int32> ProjectileSources;
+
+	struct FExplosion
+	{
+		float Time = 0.f;
+		FVector3f Location = FVector3f::ZeroVector;
+	};
+	TArray<FExplosion> Explosions;
+
+	float GetDuration() const { return NumFrames * SampleInterval; }
+};
+
+/**
+ * Keeps the last few seconds of play in memory for kill-cams and instant replays, without demo files.
+ *
+ * Characters, projectiles and explosions are sampled at a fixed rate into preallocated rings: one per character slot,
+ * each with a hard byte cap, and one for projectiles and explosions. A keyframe with absolute positions starts every
+ * KeyframeInterval seconds, frames in between are quantized residuals against a constant-velocity prediction
+ * (TPQuantization, like ghost recordings). Nothing is allocated while recording, the oldest keyframe is simply
+ * overwritten once the ring is full.
+ *
+ * Playback decodes the buffer into an ATP_ReplayViewer: instanced stand-ins and a camera, with the live characters and
+ * projectiles hidden from that player only. The world keeps simulating underneath.
+ */
+UCLASS(config=Game)
+class THIRDYEARPROJECT_API UTP_ReplaySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Samples per second */
+	UPROPERTY(config)
+	int32 SampleRate = 20;
+
+	/** Seconds between keyframes, also how much history is dropped at once when a ring is full */
+	UPROPERTY(config)
+	float KeyframeInterval = 1.f;
+
+	/** Keyframe chunks per ring, the history kept is about this many keyframe intervals */
+	UPROPERTY(config)
+	int32 ChunksPerBuffer = 20;
+
+	/** Hard memory cap of each character's ring */
+	UPROPERTY(config)
+	int32 MaxBytesPerCharacter = 16 * 1024;
+
+	/** Characters that can be recorded at once, all of their rings are allocated up front */
+	UPROPERTY(config)
+	int32 MaxRecordedCharacters = 16;
+
+	/** Hard memory cap of the projectile and explosion ring */
+	UPROPERTY(config)
+	int32 MaxWorldBytes = 256 * 1024;
+
+	/** Gives Character a ring, recording starts with the next sample */
+	void RegisterCharacter(AThirdYearProjectCharacter* Character);
+
+	/** Records Projectile while it flies, unless MaxProjectilesPerFrame are tracked already */
+	void RegisterProjectile(AThirdYearProjectProjectile* Projectile);
+
+	/** Recorded with the next sample */
+	void RecordExplosion(const FVector& Location);
+
+	/** Decodes the last Seconds of every ring, returns false when nothing is recorded yet */
+	bool BuildSnapshot(float Seconds, FTP_ReplaySnapshot& OutSnapshot) const;
+
+	/** Replays the last Seconds to Viewer from Focus' point of view (or a free overview), returns the viewer actor */
+	ATP_ReplayViewer* PlayReplay(APlayerController* Viewer, float Seconds, const AThirdYearProjectCharacter* Focus);
+
+	/** Bytes reserved by every ring and scratch buffer, fixed after Initialize */
+	int32 GetAllocatedBytes() const;
+	int32 GetUsedBytes() const;
+
+	/** Recording cost averaged over every frame, sampled or not */
+	double GetAverageRecordMs() const { return NumTicks > 0 ? TotalRecordMs / NumTicks : 0.0; }
+	double GetMaxRecordMs() const { return MaxRecordMs; }
+
+	/** Seconds of history currently available to BuildSnapshot */
+	float GetBufferedSeconds() const;
+
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	// USubsystem implementation End
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// FTickableGameObject implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FCharacterSlot
+	{
+		TWeakObjectPtr<AThirdYearProjectCharacter> Character;
+		FTP_ReplayRing Ring;
+
+		/** Encoder state, mirrored by the decoder */
+		FIntVector LastPosition = FIntVector::ZeroValue;
+		FIntVector PreviousPosition = FIntVector::ZeroValue;
+		uint16 LastYaw = 0;
+	};
+
+	struct FProjectileTrack
+	{
+		const AThirdYearProjectProjectile* Projectile = nullptr;
+		FIntVector LastPosition = FIntVector::ZeroValue;
+		FIntVector PreviousPosition = FIntVector::ZeroValue;
+	};
+
+	void RecordSample();
+	void RecordCharacter(FCharacterSlot& Slot);
+	void RecordWorld();
+
+	/** Encode into Scratch without touching the encoder state, which is only advanced once the frame is stored */
+	void EncodeCharacter(const FCharacterSlot& Slot, uint8 State, const FIntVector& Position, uint16 Yaw, uint8 Pitch, bool bKeyframe);
+	void EncodeWorld(bool bKeyframe);
+
+	TArray<FCharacterSlot> CharacterSlots;
+	FTP_ReplayRing WorldRing;
+
+	TArray<TWeakObjectPtr<AThirdYearProjectProjectile>> Projectiles;
+	TArray<FVector> PendingExplosions;
+
+	/** Projectiles written in the last world frame, and the ones being written now */
+	TArray<FProjectileTrack> ProjectileTracks;
+	TArray<FProjectileTrack> NextProjectileTracks;
+
+	/** Most projectiles a world keyframe has room for */
+	int32 MaxProjectilesPerFrame = 0;
+
+	/** Frames are encoded here before going into a ring, so a frame that turns out not to fit can be redone as a keyframe */
+	TArray<uint8> Scratch;
+
+	uint32 CurrentFrame = 0;
+	float TimeSinceLastSample = 0.f;
+
+	uint64 NumTicks = 0;
+	double TotalRecordMs = 0.0;
+	double MaxRecordMs = 0.0;
+	bool bWarnedNoSlot = false;
+	bool bWarnedNoProjectileRoom = false;
+};
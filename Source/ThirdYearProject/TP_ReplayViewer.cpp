@@ -0,0 +1,215 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_ReplayViewer.h"
+#include "ThirdYearProjectCharacter.h"
+#include "ThirdYearProjectProjectile.h"
+#include "Camera/CameraComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/ConstructorHelpers.h"
+
+namespace TPReplayViewer
+{
+	/** Matches the first person camera's offset from the capsule */
+	const FVector EyeOffset(-10.f, 0.f, 60.f);
+
+	static UInstancedStaticMeshComponent* CreateInstances(AActor* Owner, const TCHAR* Name, UStaticMesh* Mesh)
+	{
+		UInstancedStaticMeshComponent* Instances = Owner->CreateDefaultSubobject<UInstancedStaticMeshComponent>(Name);
+		Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Instances->SetCanEverAffectNavigation(false);
+		Instances->CastShadow = false;
+		Instances->SetMobility(EComponentMobility::Movable);
+		Instances->SetStaticMesh(Mesh);
+		return Instances;
+	}
+}
+
+ATP_ReplayViewer::ATP_ReplayViewer()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> CylinderFinder(TEXT("/Engine/BasicShapes/Cylinder"));
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> SphereFinder(TEXT("/Engine/BasicShapes/Sphere"));
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	CharacterInstances = TPReplayViewer::CreateInstances(this, TEXT("CharacterInstances"), CylinderFinder.Object);
+	CharacterInstances->SetupAttachment(RootComponent);
+	ProjectileInstances = TPReplayViewer::CreateInstances(this, TEXT("ProjectileInstances"), SphereFinder.Object);
+	ProjectileInstances->SetupAttachment(RootComponent);
+	ExplosionInstances = TPReplayViewer::CreateInstances(this, TEXT("ExplosionInstances"), SphereFinder.Object);
+	ExplosionInstances->SetupAttachment(RootComponent);
+
+	ReplayCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("ReplayCamera"));
+	ReplayCamera->SetupAttachment(RootComponent);
+	ReplayCamera->SetUsingAbsoluteLocation(true);
+	ReplayCamera->SetUsingAbsoluteRotation(true);
+}
+
+void ATP_ReplayViewer::StartPlayback(FTP_ReplaySnapshot&& InSnapshot, APlayerController* InViewer, int32 InFocusTrack)
+{
+	Snapshot = MoveTemp(InSnapshot);
+	Viewer = InViewer;
+	FocusTrack = InFocusTrack;
+	PlaybackTime = 0.f;
+
+	// Enough instances for the busiest frame, unused ones are scaled to zero
+	int32 MaxProjectiles = 0;
+	for (int32 Frame = 0; Frame < Snapshot.NumFrames; ++Frame)
+	{
+		MaxProjectiles = FMath::Max(MaxProjectiles, Snapshot.ProjectileStarts[Frame + 1] - Snapshot.ProjectileStarts[Frame]);
+	}
+
+	const FTransform Hidden(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+	CharacterTransforms.Init(Hidden, Snapshot.Characters.Num());
+	ProjectileTransforms.Init(Hidden, MaxProjectiles);
+	ExplosionTransforms.Init(Hidden, Snapshot.Explosions.Num());
+	CharacterInstances->AddInstances(CharacterTransforms, false, true);
+	ProjectileInstances->AddInstances(ProjectileTransforms, false, true);
+	ExplosionInstances->AddInstances(ExplosionTransforms, false, true);
+
+	if (FocusTrack == INDEX_NONE && InViewer->PlayerCameraManager != nullptr)
+	{
+		ReplayCamera->SetWorldLocationAndRotation(InViewer->PlayerCameraManager->GetCameraLocation(), InViewer->PlayerCameraManager->GetCameraRotation());
+	}
+
+	InViewer->SetViewTarget(this);
+	HideLiveActors();
+}
+
+void ATP_ReplayViewer::StopPlayback()
+{
+	RestoreView();
+	Destroy();
+}
+
+void ATP_ReplayViewer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	RestoreView();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ATP_ReplayViewer::RestoreView()
+{
+	if (APlayerController* PlayerController = Viewer.Get())
+	{
+		PlayerController->HiddenActors.Reset();
+		if (PlayerController->GetViewTarget() == this && PlayerController->GetPawn() != nullptr)
+		{
+			PlayerController->SetViewTarget(PlayerController->GetPawn());
+		}
+	}
+	Viewer.Reset();
+}
+
+void ATP_ReplayViewer::HideLiveActors()
+{
+	APlayerController* PlayerController = Viewer.Get();
+	if (PlayerController == nullptr)
+	{
+		return;
+	}
+
+	// Refreshed every tick so projectiles fired during the replay stay hidden too
+	PlayerController->HiddenActors.Reset();
+	for (TActorIterator<AThirdYearProjectCharacter> It(GetWorld()); It; ++It)
+	{
+		PlayerController->HiddenActors.Add(*It);
+
+		// Weapons and anything else carried would otherwise float where the live character is
+		It->GetAttachedActors(AttachedActors, true, true);
+		for (AActor* Attached : AttachedActors)
+		{
+			PlayerController->HiddenActors.Add(Attached);
+		}
+	}
+	for (TActorIterator<AThirdYearProjectProjectile> It(GetWorld()); It; ++It)
+	{
+		PlayerController->HiddenActors.Add(*It);
+	}
+}
+
+void ATP_ReplayViewer::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!Viewer.IsValid() || Snapshot.NumFrames == 0)
+	{
+		return;
+	}
+
+	PlaybackTime += DeltaTime;
+	if (PlaybackTime >= Snapshot.GetDuration())
+	{
+		StopPlayback();
+		return;
+	}
+
+	HideLiveActors();
+
+	const float SampleTime = PlaybackTime / Snapshot.SampleInterval;
+	const int32 Index = FMath::Min(FMath::FloorToInt32(SampleTime), Snapshot.NumFrames - 1);
+	const int32 NextIndex = FMath::Min(Index + 1, Snapshot.NumFrames - 1);
+	const float Alpha = FMath::Clamp(SampleTime - Index, 0.f, 1.f);
+
+	for (int32 TrackIndex = 0; TrackIndex < Snapshot.Characters.Num(); ++TrackIndex)
+	{
+		const FTP_ReplaySnapshot::FCharacterTrack& Track = Snapshot.Characters[TrackIndex];
+		const FTP_GhostSample& From = Track.Samples[Index];
+		const FTP_GhostSample& To = Track.Samples[NextIndex];
+
+		const FVector Location = FMath::Lerp(FVector(From.Location), FVector(To.Location), Alpha);
+		const float Yaw = From.Yaw + FRotator::NormalizeAxis(To.Yaw - From.Yaw) * Alpha;
+
+		if (TrackIndex == FocusTrack)
+		{
+			const float Pitch = FMath::Lerp(From.Pitch, To.Pitch, Alpha);
+			ReplayCamera->SetWorldLocationAndRotation(Location + FRotator(0.f, Yaw, 0.f).RotateVector(TPReplayViewer::EyeOffset), FRotator(Pitch, Yaw, 0.f));
+		}
+
+		// The focused character is the camera, characters that weren't around are hidden
+		const bool bVisible = TrackIndex != FocusTrack && Track.Present[Index];
+		FVector Scale = bVisible ? CharacterScale : FVector::ZeroVector;
+		if (From.State & TPGhostState::Sliding)
+		{
+			Scale.Z *= 0.5f;
+		}
+		CharacterTransforms[TrackIndex] = FTransform(FRotator(0.f, Yaw, 0.f), Location, Scale);
+	}
+
+	// Next frame's projectiles, moving in from where they were this frame
+	const int32 ProjectileStart = Snapshot.ProjectileStarts[NextIndex];
+	const int32 NumProjectiles = Snapshot.ProjectileStarts[NextIndex + 1] - ProjectileStart;
+	for (int32 Instance = 0; Instance < ProjectileTransforms.Num(); ++Instance)
+	{
+		if (Instance >= NumProjectiles)
+		{
+			ProjectileTransforms[Instance].SetScale3D(FVector::ZeroVector);
+			continue;
+		}
+
+		const FVector To(Snapshot.ProjectileLocations[ProjectileStart + Instance]);
+		const int32 Source = Snapshot.ProjectileSources[ProjectileStart + Instance];
+		const FVector From = Source != INDEX_NONE && NextIndex != Index ? FVector(Snapshot.ProjectileLocations[Snapshot.ProjectileStarts[Index] + Source]) : To;
+		ProjectileTransforms[Instance] = FTransform(FQuat::Identity, FMath::Lerp(From, To, Alpha), FVector(ProjectileScale));
+	}
+
+	for (int32 Instance = 0; Instance < ExplosionTransforms.Num(); ++Instance)
+	{
+		const FTP_ReplaySnapshot::FExplosion& Explosion = Snapshot.Explosions[Instance];
+		const float Age = (PlaybackTime - Explosion.Time) / ExplosionDuration;
+		const float Scale = Age >= 0.f && Age < 1.f ? ExplosionRadius / 50.f * Age : 0.f;
+		ExplosionTransforms[Instance] = FTransform(FQuat::Identity, FVector(Explosion.Location), FVector(Scale));
+	}
+
+	CharacterInstances->BatchUpdateInstancesTransforms(0, CharacterTransforms, true, true, true);
+	ProjectileInstances->BatchUpdateInstancesTransforms(0, ProjectileTransforms, true, true, true);
+	ExplosionInstances->BatchUpdateInstancesTransforms(0, ExplosionTransforms, true, true, true);
+}
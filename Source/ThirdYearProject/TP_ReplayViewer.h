@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "TP_ReplaySubsystem.h"
+#include "TP_ReplayViewer.generated.h"
+
+class APlayerController;
+class UCameraComponent;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Plays a replay snapshot back to one player as a lightweight copy of the scene: characters, projectiles and explosions
+ * are instances (like ghosts), seen through this actor's camera. The live characters and projectiles are hidden from
+ * that player while it plays and nothing else in the world is touched. Destroys itself when the replay ends.
+ */
+UCLASS()
+class THIRDYEARPROJECT_API ATP_ReplayViewer : public AActor
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category=Replay)
+	UInstancedStaticMeshComponent* CharacterInstances;
+
+	UPROPERTY(VisibleAnywhere, Category=Replay)
+	UInstancedStaticMeshComponent* ProjectileInstances;
+
+	UPROPERTY(VisibleAnywhere, Category=Replay)
+	UInstancedStaticMeshComponent* ExplosionInstances;
+
+	UPROPERTY(VisibleAnywhere, Category=Replay)
+	UCameraComponent* ReplayCamera;
+
+public:
+	ATP_ReplayViewer();
+
+	/** Shows Snapshot to Viewer, through the eyes of character track FocusTrack or from Viewer's current camera if INDEX_NONE */
+	void StartPlayback(FTP_ReplaySnapshot&& InSnapshot, APlayerController* InViewer, int32 InFocusTrack);
+
+	/** Gives the view back to the player and destroys the viewer */
+	UFUNCTION(BlueprintCallable, Category=Replay)
+	void StopPlayback();
+
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Same proportions as ghosts, relative to /Engine/BasicShapes/Cylinder */
+	UPROPERTY(EditAnywhere, Category=Replay)
+	FVector CharacterScale = FVector(1.1f, 1.1f, 1.92f);
+
+	/** Relative to the 100uu /Engine/BasicShapes/Sphere */
+	UPROPERTY(EditAnywhere, Category=Replay)
+	float ProjectileScale = 0.1f;
+
+	/** Explosions show as a sphere growing to this radius */
+	UPROPERTY(EditAnywhere, Category=Replay)
+	float ExplosionRadius = 150.f;
+
+	UPROPERTY(EditAnywhere, Category=Replay)
+	float ExplosionDuration = 0.3f;
+
+private:
+	void HideLiveActors();
+	void RestoreView();
+
+	FTP_ReplaySnapshot Snapshot;
+	TWeakObjectPtr<APlayerController> Viewer;
+	int32 FocusTrack = INDEX_NONE;
+	float PlaybackTime = 0.f;
+
+	/** Reused every tick so playback doesn't allocate */
+	TArray<FTransform> CharacterTransforms;
+	TArray<FTransform> ProjectileTransforms;
+	TArray<FTransform> ExplosionTransforms;
+	TArray<AActor*> AttachedActors;
+};
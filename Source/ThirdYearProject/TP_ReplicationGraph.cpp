@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_ReplicationGraph.h"
+#include "ThirdYearProject.h"
+#include "ThirdYearProjectCharacter.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTPReplicationGraph);
+
+DECLARE_CYCLE_STAT(TEXT("Server Replicate Actors"), STAT_TPServerReplicateActors, STATGROUP_ThirdYearProject);
+DECLARE_CYCLE_STAT(TEXT("Character Net Frequencies"), STAT_TPCharacterNetFrequencies, STATGROUP_ThirdYearProject);
+
+void UTP_ReplicationGraphNode_CharacterGrid::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	// Lists gathered by earlier nodes are already in there, only look at the ones the grid adds
+	const int32 FirstList = Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default).Num();
+
+	Super::GatherActorListsForConnection(Params);
+
+	CastChecked<UTP_ReplicationGraph>(GetOuter())->ScaleGatheredCharacterFrequencies(Params, FirstList);
+}
+
+UTP_ReplicationGraph* UTP_ReplicationGraph::Get(const UWorld* World)
+{
+	const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	return NetDriver ? Cast<UTP_ReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+}
+
+void UTP_ReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Characters start at the fastest rate, the grid lowers it per connection
+	FClassReplicationInfo CharacterInfo;
+	CharacterInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(MaxCharacterFrequency);
+	CharacterInfo.SetCullDistanceSquared(AThirdYearProjectCharacter::StaticClass()->GetDefaultObject<AActor>()->NetCullDistanceSquared);
+	GlobalActorReplicationInfoMap.SetClassInfo(AThirdYearProjectCharacter::StaticClass(), CharacterInfo);
+}
+
+void UTP_ReplicationGraph::InitGlobalGraphNodes()
+{
+	// As UBasicReplicationGraph, with the character-aware grid
+	GridNode = CreateNewNode<UTP_ReplicationGraphNode_CharacterGrid>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = FVector2D(-UE_OLD_WORLD_MAX, -UE_OLD_WORLD_MAX);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	AddGlobalGraphNode(CreateNewNode<UReplicationGraphNode_PlayerStateFrequencyLimiter>());
+}
+
+void UTP_ReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	Super::RouteAddNetworkActorToNodes(ActorInfo, GlobalInfo);
+
+	if (AThirdYearProjectCharacter* Character = Cast<AThirdYearProjectCharacter>(ActorInfo.Actor))
+	{
+		Characters.Add(Character);
+	}
+}
+
+void UTP_ReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	Super::RouteRemoveNetworkActorToNodes(ActorInfo);
+
+	if (AThirdYearProjectCharacter* Character = Cast<AThirdYearProjectCharacter>(ActorInfo.Actor))
+	{
+		Characters.RemoveSingleSwap(Character, false);
+		CharacterSpeedFrequencies.Remove(Character);
+	}
+}
+
+int32 UTP_ReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPServerReplicateActors);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	UpdateCharacterSpeedFrequencies();
+	const int32 Result = Super::ServerReplicateActors(DeltaSeconds);
+
+	LastReplicateMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	TotalReplicateMs += LastReplicateMs;
+	++NumFrames;
+	return Result;
+}
+
+void UTP_ReplicationGraph::UpdateCharacterSpeedFrequencies()
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPCharacterNetFrequencies);
+
+	// Same for every connection, so once per character
+	for (const AThirdYearProjectCharacter* Character : Characters)
+	{
+		const float SpeedAlpha = FMath::Min(Character->GetVelocity().Size() / FastCharacterSpeed, 1.f);
+		CharacterSpeedFrequencies.Add(Character, FMath::Lerp(MinCharacterFrequency, MaxCharacterFrequency, SpeedAlpha));
+	}
+}
+
+void UTP_ReplicationGraph::ScaleGatheredCharacterFrequencies(const FConnectionGatherActorListParameters& Params, int32 FirstList)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPCharacterNetFrequencies);
+
+	const float InvFarRange = 1.f / FMath::Max(FarDistance - NearDistance, 1.f);
+	const TArray<FActorRepListRefView>& Lists = Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default);
+	for (int32 ListIndex = FirstList; ListIndex < Lists.Num(); ++ListIndex)
+	{
+		for (FActorRepListType Actor : Lists[ListIndex])
+		{
+			const float* SpeedFrequency = CharacterSpeedFrequencies.Find(Actor);
+			if (SpeedFrequency == nullptr)
+			{
+				continue;
+			}
+
+			// Closest viewer of the connection (split screen has several)
+			float DistanceSq = MAX_flt;
+			for (const FNetViewer& Viewer : Params.Viewers)
+			{
+				DistanceSq = FMath::Min(DistanceSq, static_cast<float>(FVector::DistSquared(Actor->GetActorLocation(), Viewer.ViewLocation)));
+			}
+			const float DistanceAlpha = FMath::Clamp((FMath::Sqrt(DistanceSq) - NearDistance) * InvFarRange, 0.f, 1.f);
+
+			// Speed sets the rate, distance scales it down
+			const float Frequency = FMath::Max(*SpeedFrequency * FMath::Lerp(1.f, FarFrequencyScale, DistanceAlpha), MinCharacterFrequency);
+			Params.ConnectionManager.ActorInfoMap.FindOrAdd(Actor).ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(Frequency);
+		}
+	}
+}
+
+void UTP_ReplicationGraph::ResetStats()
+{
+	NumFrames = 0;
+	TotalReplicateMs = 0.0;
+	LastReplicateMs = 0.0;
+}
+
+static FAutoConsoleCommandWithWorld GTPRepGraphStatsCommand(
+	TEXT("TP.RepGraph.Stats"),
+	TEXT("Logs server replication cost per connection and resets the average"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UTP_ReplicationGraph* Graph = UTP_ReplicationGraph::Get(World);
+		if (Graph == nullptr)
+		{
+			UE_LOG(LogTPReplicationGraph, Warning, TEXT("No replication graph, run this on a server"));
+			return;
+		}
+
+		const int32 NumConnections = Graph->GetNumConnections();
+		UE_LOG(LogTPReplicationGraph, Display, TEXT("%d connections, %d characters: ServerReplicateActors %.3f ms average (%.3f ms last), %.4f ms per connection"),
+			NumConnections, Graph->GetNumCharacters(), Graph->GetAverageReplicateMs(), Graph->GetLastReplicateMs(),
+			NumConnections > 0 ? Graph->GetAverageReplicateMs() / NumConnections : 0.0);
+		Graph->ResetStats();
+	}));
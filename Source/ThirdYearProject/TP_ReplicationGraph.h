@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BasicReplicationGraph.h"
+#include "TP_ReplicationGraph.generated.h"
+
+class AThirdYearProjectCharacter;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPReplicationGraph, Log, All);
+
+/**
+ * Spatial grid that also sets the update rate of the characters it gathers for a connection, by distance from that
+ * connection's viewers. Only characters in the cells around the view are touched, not every character.
+ */
+UCLASS()
+class THIRDYEARPROJECT_API UTP_ReplicationGraphNode_CharacterGrid : public UReplicationGraphNode_GridSpatialization2D
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+};
+
+/**
+ * Replication graph for large lobbies, enabled for IpNetDriver in DefaultEngine.ini.
+ *
+ * Instead of checking every actor against every connection each tick, actors live in a 2D spatial grid and each
+ * connection only gathers the cells around its view; always relevant and owner-only actors go to their own lists
+ * (see UBasicReplicationGraph). Dormant actors such as pickups sit in the grid's static lists until they wake up.
+ *
+ * On top of that, characters update at a rate per connection picked from how fast they move and how far they are from
+ * that connection's view: a wall-running player nearby gets MaxCharacterFrequency, an idle one at the edge of the cull
+ * distance gets MinCharacterFrequency. The speed part is worked out once per character per frame, the distance part
+ * only for characters the grid gathers for a connection (UTP_ReplicationGraphNode_CharacterGrid). ServerReplicateActors is timed for TP.RepGraph.Stats and the net benchmark.
+ */
+UCLASS(transient, config=Game)
+class THIRDYEARPROJECT_API UTP_ReplicationGraph : public UBasicReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	/** Grid cell size, about the distance a character covers between two low-rate updates */
+	UPROPERTY(config)
+	float GridCellSize = 10000.f;
+
+	/** Network updates per second of a fast, close character, and of an idle, far one */
+	UPROPERTY(config)
+	float MaxCharacterFrequency = 60.f;
+
+	UPROPERTY(config)
+	float MinCharacterFrequency = 5.f;
+
+	/** Speed at which a character counts as fully fast, wall-runs and slides reach it */
+	UPROPERTY(config)
+	float FastCharacterSpeed = 1200.f;
+
+	/** Up to this distance from a viewer characters aren't slowed down by distance */
+	UPROPERTY(config)
+	float NearDistance = 1500.f;
+
+	/** Distance at which the distance scaling bottoms out, at FarFrequencyScale of the speed-based rate */
+	UPROPERTY(config)
+	float FarDistance = 10000.f;
+
+	UPROPERTY(config)
+	float FarFrequencyScale = 0.25f;
+
+	/** Replication graph of World's game net driver, if it uses this class */
+	static UTP_ReplicationGraph* Get(const UWorld* World);
+
+	/** Average and last game thread time of ServerReplicateActors since the last ResetStats */
+	double GetAverageReplicateMs() const { return NumFrames > 0 ? TotalReplicateMs / NumFrames : 0.0; }
+	double GetLastReplicateMs() const { return LastReplicateMs; }
+	int32 GetNumConnections() const { return Connections.Num(); }
+	int32 GetNumCharacters() const { return Characters.Num(); }
+	void ResetStats();
+
+	// UReplicationGraph interface begin
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+	// UReplicationGraph interface end
+
+private:
+	friend class UTP_ReplicationGraphNode_CharacterGrid;
+
+	/** Works out every character's speed-based update rate for this frame */
+	void UpdateCharacterSpeedFrequencies();
+
+	/** Sets the replication period of the characters in Params' gathered lists from index FirstList on, by distance to the viewers */
+	void ScaleGatheredCharacterFrequencies(const FConnectionGatherActorListParameters& Params, int32 FirstList);
+
+	TArray<AThirdYearProjectCharacter*> Characters;
+
+	/** Updates per second of each character from its speed alone, refilled every frame */
+	TMap<const AActor*, float> CharacterSpeedFrequencies;
+
+	uint64 NumFrames = 0;
+	double TotalReplicateMs = 0.0;
+	double LastReplicateMs = 0.0;
+};
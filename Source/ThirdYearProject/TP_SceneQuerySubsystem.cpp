@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_SceneQuerySubsystem.h"
+#include "ThirdYearProject.h"
+#include "ThirdYearProjectCharacter.h"
+#include "ThirdYearProjectGameMode.h"
+#include "TP_ParkourMovementModel.h"
+#include "Async/ParallelFor.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTPSceneQuery);
+
+DECLARE_CYCLE_STAT(TEXT("Batched Wall Probes"), STAT_TPWallProbes, STATGROUP_ThirdYearProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wall Probes"), STAT_TPWallProbeCount, STATGROUP_ThirdYearProject);
+
+namespace TPSceneQuery
+{
+	/** Below this many probes the batch runs inline, task dispatch would cost more than the traces */
+	constexpr int32 MinParallelProbes = 4;
+
+	/** A cached probe further than this from the character, or turned by more than MinProbeFacingDot, is re-traced */
+	constexpr float MaxProbeDrift = 25.f;
+	constexpr float MinProbeFacingDot = 0.995f;
+
+	/** Frames skipped after changing the player count so spawning doesn't pollute the measurement */
+	constexpr int32 BenchWarmupFrames = 60;
+}
+
+bool UTP_SceneQuerySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTP_SceneQuerySubsystem::RegisterCharacter(AThirdYearProjectCharacter* Character)
+{
+	if (Character == nullptr || ProbeIndices.Contains(Character))
+	{
+		return;
+	}
+
+	ProbeIndices.Add(Character, WallProbes.Num());
+	WallProbes.AddDefaulted_GetRef().Character = Character;
+}
+
+ETP_ProbeResult UTP_SceneQuerySubsystem::GetWallProbe(const AThirdYearProjectCharacter* Character, FVector& OutWallNormal) const
+{
+	const int32* Index = ProbeIndices.Find(Character);
+	if (Index == nullptr)
+	{
+		return ETP_ProbeResult::Unknown;
+	}
+
+	// One local player gains nothing from batching, and a late wall-run start is noticeable; trace on time instead
+	const UGameInstance* GameInstance = GetWorld()->GetGameInstance();
+	if (GameInstance == nullptr || GameInstance->GetNumLocalPlayers() <= 1)
+	{
+		return ETP_ProbeResult::Unknown;
+	}
+
+	// Traced at the end of last frame (or up to ProbeInterval frames ago); too far off from where the character is now
+	// and it would start wall runs late, so the character probes again itself
+	const FWallProbe& Probe = WallProbes[*Index];
+	if (FVector::DistSquared(Probe.Start, Character->GetActorLocation()) > FMath::Square(TPSceneQuery::MaxProbeDrift)
+		|| FVector::DotProduct(Probe.Right, Character->GetActorRightVector()) < TPSceneQuery::MinProbeFacingDot)
+	{
+		return ETP_ProbeResult::Unknown;
+	}
+
+	if (Probe.Result == ETP_ProbeResult::Hit)
+	{
+		OutWallNormal = Probe.Normal;
+	}
+	return Probe.Result;
+}
+
+void UTP_SceneQuerySubsystem::RunWallProbes()
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPWallProbes);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// Destroyed characters are rare, compact and reindex only when one shows up
+	if (WallProbes.RemoveAll([](const FWallProbe& Probe) { return !Probe.Character.IsValid(); }) > 0)
+	{
+		ProbeIndices.Reset();
+		for (int32 Index = 0; Index < WallProbes.Num(); ++Index)
+		{
+			ProbeIndices.Add(WallProbes[Index].Character.Get(), Index);
+		}
+	}
+
+	// Gather on the game thread, characters only probe for walls while airborne
+	NumQueries = 0;
+	for (FWallProbe& Probe : WallProbes)
+	{
+		const AThirdYearProjectCharacter* Character = Probe.Character.Get();
+		const bool bAirborne = Character->GetCharacterMovement() != nullptr && Character->GetCharacterMovement()->IsFalling();
+
+		Probe.Result = bAirborne ? ETP_ProbeResult::Miss : ETP_ProbeResult::Unknown;
+		Probe.Start = Character->GetActorLocation();
+		Probe.Right = Character->GetActorRightVector();
+		NumQueries += bAirborne ? 1 : 0;
+	}
+
+	const UWorld* World = GetWorld();
+	ParallelFor(WallProbes.Num(), [this, World](int32 Index)
+	{
+		FWallProbe& Probe = WallProbes[Index];
+		if (Probe.Result == ETP_ProbeResult::Unknown)
+		{
+			return;
+		}
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TPWallProbe), false, Probe.Character.Get());
+		const FVector Offset = Probe.Right * FTP_ParkourMovementModel::WallProbeDistance;
+
+		// Same order as the character's own probe: right side first, then left
+		FHitResult HitResult;
+		if (World->LineTraceSingleByChannel(HitResult, Probe.Start, Probe.Start + Offset, ECC_Visibility, QueryParams)
+			|| World->LineTraceSingleByChannel(HitResult, Probe.Start, Probe.Start - Offset, ECC_Visibility, QueryParams))
+		{
+			Probe.Normal = HitResult.Normal;
+			Probe.Result = ETP_ProbeResult::Hit;
+		}
+	}, NumQueries < TPSceneQuery::MinParallelProbes ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	LastBatchMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	SET_DWORD_STAT(STAT_TPWallProbeCount, NumQueries);
+}
+
+void UTP_SceneQuerySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// World tickables run after every tick group, so this sees where characters ended up this frame
+	if (++FramesSinceProbes >= ProbeInterval)
+	{
+		FramesSinceProbes = 0;
+		RunWallProbes();
+	}
+
+	if (BenchFramesPerStep > 0)
+	{
+		TickBenchmark();
+	}
+}
+
+TStatId UTP_SceneQuerySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTP_SceneQuerySubsystem, STATGROUP_Tickables);
+}
+
+void UTP_SceneQuerySubsystem::StartBenchmark(int32 FramesPerStep)
+{
+	if (BenchFramesPerStep > 0)
+	{
+		return;
+	}
+
+	AThirdYearProjectGameMode* GameMode = GetWorld()->GetAuthGameMode<AThirdYearProjectGameMode>();
+	if (GameMode == nullptr)
+	{
+		UE_LOG(LogTPSceneQuery, Error, TEXT("Split-screen benchmark needs a local game using AThirdYearProjectGameMode"));
+		return;
+	}
+
+	BenchFramesPerStep = FMath::Max(FramesPerStep, 1);
+	BenchFrame = 0;
+	BenchPlayers = 1;
+	BenchRestorePlayers = GetWorld()->GetGameInstance()->GetNumLocalPlayers();
+	BenchSteps.Reset();
+	BenchSteps.AddDefaulted();
+	GameMode->SetNumLocalPlayers(BenchPlayers);
+}
+
+void UTP_SceneQuerySubsystem::TickBenchmark()
+{
+	AThirdYearProjectGameMode* GameMode = GetWorld()->GetAuthGameMode<AThirdYearProjectGameMode>();
+	if (GameMode == nullptr)
+	{
+		BenchFramesPerStep = 0;
+		return;
+	}
+
+	// GGameThreadTime is last frame's game thread time, which is all the CPU work split-screen adds headless
+	++BenchFrame;
+	if (BenchFrame > TPSceneQuery::BenchWarmupFrames)
+	{
+		FBenchmarkStep& Step = BenchSteps.Last();
+		Step.GameThreadMs += FPlatformTime::ToMilliseconds(GGameThreadTime);
+		Step.QueryMs += LastBatchMs;
+		Step.Queries += NumQueries;
+	}
+
+	if (BenchFrame < TPSceneQuery::BenchWarmupFrames + BenchFramesPerStep)
+	{
+		return;
+	}
+
+	if (BenchPlayers < AThirdYearProjectGameMode::MaxLocalPlayers)
+	{
+		++BenchPlayers;
+		BenchFrame = 0;
+		BenchSteps.AddDefaulted();
+		GameMode->SetNumLocalPlayers(BenchPlayers);
+		return;
+	}
+
+	const double BaseMs = BenchSteps[0].GameThreadMs / BenchFramesPerStep;
+	UE_LOG(LogTPSceneQuery, Display, TEXT("Split-screen benchmark, %d frames per step:"), BenchFramesPerStep);
+	for (int32 Index = 0; Index < BenchSteps.Num(); ++Index)
+	{
+		const FBenchmarkStep& Step = BenchSteps[Index];
+		const double GameThreadMs = Step.GameThreadMs / BenchFramesPerStep;
+		UE_LOG(LogTPSceneQuery, Display, TEXT("  %d player(s): %.3f ms game thread (x%.2f), %.3f ms batched queries, %.1f probes/frame"),
+			Index + 1, GameThreadMs, BaseMs > 0.0 ? GameThreadMs / BaseMs : 0.0, Step.QueryMs / BenchFramesPerStep, static_cast<float>(Step.Queries) / BenchFramesPerStep);
+	}
+
+	BenchFramesPerStep = 0;
+	GameMode->SetNumLocalPlayers(BenchRestorePlayers);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPSplitScreenBenchCommand(
+	TEXT("TP.SplitScreen.Bench"),
+	TEXT("Measures game thread cost with 1 to 4 local players, run headless with -nullrhi. Usage: TP.SplitScreen.Bench [FramesPerStep=300]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTP_SceneQuerySubsystem* Subsystem = World->GetSubsystem<UTP_SceneQuerySubsystem>())
+		{
+			Subsystem->StartBenchmark(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 300);
+		}
+	}));
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TP_SceneQuerySubsystem.generated.h"
+
+class AThirdYearProjectCharacter;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPSceneQuery, Log, All);
+
+/** Outcome of a batched probe, Unknown when the character has to probe itself */
+enum class ETP_ProbeResult : uint8
+{
+	Unknown,
+	Miss,
+	Hit
+};
+
+/**
+ * Runs the per-frame scene queries of every character in one batch instead of one character at a time.
+ *
+ * Characters register on BeginPlay. At the end of each frame, once movement and physics are done, the wall probes of all
+ * airborne characters are traced together across worker threads and cached; each character's Tick reads its result
+ * from the cache instead of tracing itself. With split-screen that keeps the cost of extra local players (and bots) on
+ * the task graph instead of adding serial game thread traces per pawn. With a single local player, or when a character
+ * has moved or turned since its probe was traced, the cache is skipped and the character traces on time itself.
+ */
+UCLASS()
+class THIRDYEARPROJECT_API UTP_SceneQuerySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterCharacter(AThirdYearProjectCharacter* Character);
+
+	/** Wall found by Character's batched side probes at the end of last frame, Unknown when it should probe itself */
+	ETP_ProbeResult GetWallProbe(const AThirdYearProjectCharacter* Character, FVector& OutWallNormal) const;
+
+	/** Runs the wall probe batch every Frames frames, characters read results up to that many frames old in between */
+	void SetProbeInterval(int32 Frames) { ProbeInterval = FMath::Max(Frames, 1); }
+	int32 GetProbeInterval() const { return ProbeInterval; }
+
+	/** Probes run by the last batch and the time it took */
+	int32 GetNumQueries() const { return NumQueries; }
+	double GetLastBatchMs() const { return LastBatchMs; }
+
+	/** Measures the game thread cost of 1 to 4 local players, FramesPerStep frames each */
+	void StartBenchmark(int32 FramesPerStep);
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// FTickableGameObject implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FWallProbe
+	{
+		TWeakObjectPtr<AThirdYearProjectCharacter> Character;
+		FVector Start = FVector::ZeroVector;
+		FVector Right = FVector::ZeroVector;
+		FVector Normal = FVector::ZeroVector;
+		ETP_ProbeResult Result = ETP_ProbeResult::Unknown;
+	};
+
+	void RunWallProbes();
+	void TickBenchmark();
+
+	/** One entry per registered character, in registration order */
+	TArray<FWallProbe> WallProbes;
+
+	/** Character -> index into WallProbes */
+	TMap<TObjectKey<AThirdYearProjectCharacter>, int32> ProbeIndices;
+
+	int32 NumQueries = 0;
+	double LastBatchMs = 0.0;
+
+	int32 ProbeInterval = 1;
+	int32 FramesSinceProbes = 0;
+
+	struct FBenchmarkStep
+	{
+		double GameThreadMs = 0.0;
+		double QueryMs = 0.0;
+		int32 Queries = 0;
+	};
+
+	/** Frames measured per player count, 0 when no benchmark is running */
+	int32 BenchFramesPerStep = 0;
+	int32 BenchFrame = 0;
+	int32 BenchPlayers = 0;
+	int32 BenchRestorePlayers = 1;
+	TArray<FBenchmarkStep, TInlineAllocator<4>> BenchSteps;
+};
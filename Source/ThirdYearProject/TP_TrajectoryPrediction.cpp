@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_TrajectoryPrediction.h"
+#include "TP_ParkourMovementModel.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/VectorRegister.h"
+
+DEFINE_LOG_CATEGORY(LogTPTrajectory);
+
+namespace TPTrajectory
+{
+	/** Padding entries are a harmless standing start under normal gravity */
+	constexpr float DefaultGravityZ = -980.f;
+
+	/** How far below the first estimate the floor trace looks */
+	constexpr float MaxDropHeight = 5000.f;
+
+	/** Below this many trajectories the floor traces run inline */
+	constexpr int32 MinParallelTraces = 16;
+}
+
+void FTP_TrajectoryBatch::Reset()
+{
+	NumTrajectories = 0;
+	for (TArray<float>* Array : { &PosX, &PosY, &PosZ, &VelX, &VelY, &VelZ, &GravityZ, &FloorZ, &LandX, &LandY, &LandZ, &TimeOfFlight })
+	{
+		Array->Reset();
+	}
+}
+
+int32 FTP_TrajectoryBatch::Add(const FVector& Location, const FVector& Velocity, float InGravityZ)
+{
+	// Grow four lanes at a time so the solver never reads past the end
+	if (NumTrajectories % 4 == 0)
+	{
+		for (TArray<float>* Array : { &PosX, &PosY, &PosZ, &VelX, &VelY, &VelZ, &FloorZ, &LandX, &LandY, &LandZ, &TimeOfFlight })
+		{
+			Array->AddZeroed(4);
+		}
+		for (int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			GravityZ.Add(TPTrajectory::DefaultGravityZ);
+		}
+	}
+
+	const int32 Index = NumTrajectories++;
+	PosX[Index] = Location.X;
+	PosY[Index] = Location.Y;
+	PosZ[Index] = Location.Z;
+	VelX[Index] = Velocity.X;
+	VelY[Index] = Velocity.Y;
+	VelZ[Index] = Velocity.Z;
+	GravityZ[Index] = FMath::Min(InGravityZ, -UE_KINDA_SMALL_NUMBER);
+	FloorZ[Index] = Location.Z;
+	return Index;
+}
+
+FVector FTP_TrajectoryPrediction::GetLaunchVelocity(ETP_PredictedMove Move, const FVector& CurrentVelocity, const FVector& Forward, const FVector& WallNormal, float ProjectileSpeed)
+{
+	switch (Move)
+	{
+	case ETP_PredictedMove::Jump:
+		return FVector(CurrentVelocity.X, CurrentVelocity.Y, FTP_ParkourMovementModel::JumpZVelocity);
+	case ETP_PredictedMove::DoubleJump:
+		// The character launches this without overriding XY, so the current horizontal velocity counts twice
+		return FTP_ParkourMovementModel::ApplyLaunch(CurrentVelocity, FTP_ParkourMovementModel::GetDoubleJumpVelocity(CurrentVelocity, FTP_ParkourMovementModel::JumpZVelocity), false, true);
+	case ETP_PredictedMove::SlideJump:
+		return FTP_ParkourMovementModel::ApplyLaunch(CurrentVelocity, FTP_ParkourMovementModel::GetSlideJumpVelocity(Forward), true, true);
+	case ETP_PredictedMove::WallJump:
+		return FTP_ParkourMovementModel::ApplyLaunch(CurrentVelocity, FTP_ParkourMovementModel::GetWallJumpVelocity(WallNormal, Forward), true, true);
+	case ETP_PredictedMove::Projectile:
+		return Forward * ProjectileSpeed;
+	}
+	return CurrentVelocity;
+}
+
+float FTP_TrajectoryPrediction::GetCharacterGravityZ(const UWorld* World, bool bWallRunning)
+{
+	const float WorldGravityZ = World ? World->GetGravityZ() : TPTrajectory::DefaultGravityZ;
+	return bWallRunning ? WorldGravityZ * FTP_ParkourMovementModel::WallRunGravityScale : WorldGravityZ;
+}
+
+void FTP_TrajectoryPrediction::SolveLandings(FTP_TrajectoryBatch& Batch)
+{
+	// Z(t) = PosZ + VelZ t + G t^2 / 2 comes down to FloorZ at the larger root, t = (VelZ + sqrt(VelZ^2 - 2 G (PosZ - FloorZ))) / -G
+	const VectorRegister4Float Two = VectorSetFloat1(2.f);
+	const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	const VectorRegister4Float NoLanding = VectorSetFloat1(-1.f);
+
+	for (int32 Index = 0; Index < Batch.Num(); Index += 4)
+	{
+		const VectorRegister4Float PosZ = VectorLoad(&Batch.PosZ[Index]);
+		const VectorRegister4Float VelZ = VectorLoad(&Batch.VelZ[Index]);
+		const VectorRegister4Float Gravity = VectorLoad(&Batch.GravityZ[Index]);
+		const VectorRegister4Float Floor = VectorLoad(&Batch.FloorZ[Index]);
+
+		const VectorRegister4Float Height = VectorSubtract(PosZ, Floor);
+		const VectorRegister4Float Discriminant = VectorSubtract(VectorMultiply(VelZ, VelZ), VectorMultiply(VectorMultiply(Two, Gravity), Height));
+		const VectorRegister4Float Reaches = VectorCompareGE(Discriminant, Zero);
+
+		const VectorRegister4Float Root = VectorSqrt(VectorMax(Discriminant, Zero));
+		const VectorRegister4Float Time = VectorDivide(VectorAdd(VelZ, Root), VectorNegate(Gravity));
+		VectorStore(VectorSelect(Reaches, Time, NoLanding), &Batch.TimeOfFlight[Index]);
+
+		// Lanes that never come down report where they are at the apex instead
+		const VectorRegister4Float ApexTime = VectorMax(VectorDivide(VelZ, VectorNegate(Gravity)), Zero);
+		const VectorRegister4Float T = VectorSelect(Reaches, Time, ApexTime);
+
+		VectorStore(VectorMultiplyAdd(VectorLoad(&Batch.VelX[Index]), T, VectorLoad(&Batch.PosX[Index])), &Batch.LandX[Index]);
+		VectorStore(VectorMultiplyAdd(VectorLoad(&Batch.VelY[Index]), T, VectorLoad(&Batch.PosY[Index])), &Batch.LandY[Index]);
+		VectorStore(VectorMultiplyAdd(VectorMultiply(Half, Gravity), VectorMultiply(T, T), VectorMultiplyAdd(VelZ, T, PosZ)), &Batch.LandZ[Index]);
+	}
+}
+
+void FTP_TrajectoryPrediction::PredictLandings(const UWorld* World, FTP_TrajectoryBatch& Batch, const FCollisionQueryParams& QueryParams)
+{
+	// First estimate against the start height (or whatever floor the caller set)
+	SolveLandings(Batch);
+
+	ParallelFor(Batch.Num(), [World, &Batch, &QueryParams](int32 Index)
+	{
+		// Look down from the top of the arc at the estimated landing spot
+		const float ApexZ = Batch.PosZ[Index] + FMath::Max(Batch.VelZ[Index], 0.f) * Batch.VelZ[Index] / (-2.f * Batch.GravityZ[Index]);
+		const FVector Start(Batch.LandX[Index], Batch.LandY[Index], ApexZ);
+		const FVector End(Batch.LandX[Index], Batch.LandY[Index], FMath::Min(Batch.FloorZ[Index], Batch.LandZ[Index]) - TPTrajectory::MaxDropHeight);
+
+		FHitResult Hit;
+		if (World->LineTraceSingleByChannel(Hit, Start, End, ECC_Visibility, QueryParams))
+		{
+			Batch.FloorZ[Index] = Hit.ImpactPoint.Z;
+		}
+	}, Batch.Num() < TPTrajectory::MinParallelTraces ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	SolveLandings(Batch);
+}
+
+bool FTP_TrajectoryPrediction::PredictLanding(const UWorld* World, const FVector& Location, const FVector& Velocity, float GravityZ, FVector& OutLanding, float& OutTimeOfFlight, const AActor* IgnoredActor)
+{
+	FTP_TrajectoryBatch Batch;
+	Batch.Add(Location, Velocity, GravityZ);
+	PredictLandings(World, Batch, FCollisionQueryParams(SCENE_QUERY_STAT(TPTrajectory), false, IgnoredActor));
+
+	OutLanding = Batch.GetLanding(0);
+	OutTimeOfFlight = Batch.TimeOfFlight[0];
+	return OutTimeOfFlight >= 0.f;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPTrajectoryBenchCommand(
+	TEXT("TP.Trajectory.Bench"),
+	TEXT("Predicts N random jumps, wall-jumps, slide jumps and projectiles (default 10000) and logs predictions per millisecond"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 Count = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+
+		FRandomStream Random(1234);
+		FTP_TrajectoryBatch Batch;
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			const ETP_PredictedMove Move = static_cast<ETP_PredictedMove>(Index % 5);
+			const FVector Location(Random.FRandRange(-5000.f, 5000.f), Random.FRandRange(-5000.f, 5000.f), Random.FRandRange(0.f, 1000.f));
+			const FVector Forward = FVector(Random.GetUnitVector().GetSafeNormal2D());
+			const FVector WallNormal(-Forward.Y, Forward.X, 0.f);
+			const FVector Velocity = FTP_TrajectoryPrediction::GetLaunchVelocity(Move, Forward * FTP_ParkourMovementModel::SprintSpeed, Forward, WallNormal);
+			Batch.Add(Location, Velocity, FTP_TrajectoryPrediction::GetCharacterGravityZ(World));
+		}
+
+		const double SolveStart = FPlatformTime::Seconds();
+		FTP_TrajectoryPrediction::SolveLandings(Batch);
+		const double SolveMs = (FPlatformTime::Seconds() - SolveStart) * 1000.0;
+
+		const double PredictStart = FPlatformTime::Seconds();
+		FTP_TrajectoryPrediction::PredictLandings(World, Batch, FCollisionQueryParams(SCENE_QUERY_STAT(TPTrajectory), false));
+		const double PredictMs = (FPlatformTime::Seconds() - PredictStart) * 1000.0;
+
+		UE_LOG(LogTPTrajectory, Display, TEXT("%d trajectories: closed form %.3f ms (%.0f per ms), with floor queries %.3f ms (%.0f per ms)"),
+			Count, SolveMs, Count / FMath::Max(SolveMs, 0.001), PredictMs, Count / FMath::Max(PredictMs, 0.001));
+	}));
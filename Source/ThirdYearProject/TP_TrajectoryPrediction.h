@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPTrajectory, Log, All);
+
+/** Launches the character (or a projectile) can make, see FTP_ParkourMovementModel */
+enum class ETP_PredictedMove : uint8
+{
+	Jump,
+	DoubleJump,
+	SlideJump,
+	WallJump,
+	Projectile
+};
+
+/**
+ * Many ballistic start states in structure-of-arrays layout.
+ * Arrays are padded to a multiple of four so the solver can run four trajectories per SIMD register.
+ */
+struct THIRDYEARPROJECT_API FTP_TrajectoryBatch
+{
+	/** Start state */
+	TArray<float> PosX, PosY, PosZ;
+	TArray<float> VelX, VelY, VelZ;
+	TArray<float> GravityZ;
+
+	/** Height the trajectory lands at, filled by FTP_TrajectoryPrediction::PredictLandings or by the caller */
+	TArray<float> FloorZ;
+
+	/** Results: landing point, and time of flight (negative when the arc never comes down to FloorZ) */
+	TArray<float> LandX, LandY, LandZ;
+	TArray<float> TimeOfFlight;
+
+	int32 Num() const { return NumTrajectories; }
+
+	/** Empties the batch, keeping its memory */
+	void Reset();
+
+	/** Adds a start state, FloorZ defaults to the start height (so Location should be the feet); returns its index */
+	int32 Add(const FVector& Location, const FVector& Velocity, float InGravityZ);
+
+	FVector GetLanding(int32 Index) const { return FVector(LandX[Index], LandY[Index], LandZ[Index]); }
+
+private:
+	friend struct FTP_TrajectoryPrediction;
+
+	int32 NumTrajectories = 0;
+};
+
+/**
+ * Predicts where jumps, wall-jumps, slide jumps and projectiles come down, without simulating them.
+ *
+ * Between launch and landing both the character (falling) and projectiles follow a ballistic arc, so landing time is
+ * the larger root of a quadratic and is solved in closed form, four trajectories at a time. Collision is coarse: one
+ * downward trace per trajectory finds the floor near where the arc would come down, and the arc is solved again against
+ * that height. Air control, walls hit mid-flight and bounces after the first impact are not modelled.
+ */
+struct THIRDYEARPROJECT_API FTP_TrajectoryPrediction
+{
+	/** Launch velocity of Move from the current state, the same rules the character applies */
+	static FVector GetLaunchVelocity(ETP_PredictedMove Move, const FVector& CurrentVelocity, const FVector& Forward, const FVector& WallNormal = FVector::ZeroVector, float ProjectileSpeed = 3000.f);
+
+	/** Gravity a character is under, wall-running or not */
+	static float GetCharacterGravityZ(const UWorld* World, bool bWallRunning = false);
+
+	/** Solves every trajectory in the batch against its FloorZ */
+	static void SolveLandings(FTP_TrajectoryBatch& Batch);
+
+	/**
+	 * Solves the batch, then traces down once per trajectory (in parallel) near the estimated landing to set FloorZ,
+	 * and solves again. Trajectories that find no floor keep their previous FloorZ.
+	 */
+	static void PredictLandings(const UWorld* World, FTP_TrajectoryBatch& Batch, const FCollisionQueryParams& QueryParams);
+
+	/** Single-trajectory convenience for UI and gameplay code */
+	static bool PredictLanding(const UWorld* World, const FVector& Location, const FVector& Velocity, float GravityZ, FVector& OutLanding, float& OutTimeOfFlight, const AActor* IgnoredActor = nullptr);
+};
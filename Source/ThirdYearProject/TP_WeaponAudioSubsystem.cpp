@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_WeaponAudioSubsystem.h"
+#include "ThirdYearProject.h"
+#include "Components/AudioComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Sound/SoundBase.h"
+
+DEFINE_LOG_CATEGORY(LogTPWeaponAudio);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Audio Voices"), STAT_TPWeaponAudioVoices, STATGROUP_ThirdYearProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Audio Culled"), STAT_TPWeaponAudioCulled, STATGROUP_ThirdYearProject);
+
+/** Priority of the local player's own weapon, above anything distance alone can produce */
+static constexpr float LocalWeaponPriority = 2.f;
+
+bool UTP_WeaponAudioSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTP_WeaponAudioSubsystem::Deinitialize()
+{
+	for (UAudioComponent* Component : PooledComponents)
+	{
+		if (Component != nullptr)
+		{
+			Component->Stop();
+			Component->DestroyComponent();
+		}
+	}
+	PooledComponents.Reset();
+	Voices.Reset();
+	PendingShots.Reset();
+
+	Super::Deinitialize();
+}
+
+void UTP_WeaponAudioSubsystem::PlayWeaponFire(const UObject* Weapon, USoundBase* Sound, const FVector& Location, bool bLocalPlayer)
+{
+	if (Weapon == nullptr || Sound == nullptr)
+	{
+		return;
+	}
+
+	++NumRequested;
+
+	// Several shots from one weapon in the same frame are one sound
+	for (FPendingShot& Shot : PendingShots)
+	{
+		if (Shot.Weapon.Get() == Weapon)
+		{
+			Shot.Location = Location;
+			Shot.Priority = FMath::Max(Shot.Priority, bLocalPlayer ? LocalWeaponPriority : 0.f);
+			++NumMergedThisFrame;
+			return;
+		}
+	}
+
+	FPendingShot& Shot = PendingShots.AddDefaulted_GetRef();
+	Shot.Weapon = Weapon;
+	Shot.Sound = Sound;
+	Shot.Location = Location;
+	Shot.Priority = bLocalPlayer ? LocalWeaponPriority : 0.f;
+}
+
+void UTP_WeaponAudioSubsystem::EnsurePool()
+{
+	if (PooledComponents.Num() > 0)
+	{
+		return;
+	}
+
+	AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings();
+	if (WorldSettings == nullptr)
+	{
+		return;
+	}
+
+	PooledComponents.Reserve(MaxVoices);
+	Voices.Reserve(MaxVoices);
+	for (int32 Index = 0; Index < MaxVoices; ++Index)
+	{
+		UAudioComponent* Component = NewObject<UAudioComponent>(WorldSettings);
+		Component->bAutoActivate = false;
+		Component->bAutoDestroy = false;
+		Component->bAllowSpatialization = true;
+		Component->RegisterComponentWithWorld(GetWorld());
+
+		PooledComponents.Add(Component);
+		Voices.AddDefaulted_GetRef().Component = Component;
+	}
+}
+
+float UTP_WeaponAudioSubsystem::GetListenerDistance(const FVector& Location) const
+{
+	if (ListenerLocations.Num() == 0)
+	{
+		return 0.f;
+	}
+
+	float ClosestDistanceSq = TNumericLimits<float>::Max();
+	for (const FVector& ListenerLocation : ListenerLocations)
+	{
+		ClosestDistanceSq = FMath::Min(ClosestDistanceSq, static_cast<float>(FVector::DistSquared(ListenerLocation, Location)));
+	}
+	return FMath::Sqrt(ClosestDistanceSq);
+}
+
+UTP_WeaponAudioSubsystem::FVoice* UTP_WeaponAudioSubsystem::FindVoice(const UObject* Weapon, float Priority)
+{
+	FVoice* FreeVoice = nullptr;
+	FVoice* WeakestVoice = nullptr;
+	for (FVoice& Voice : Voices)
+	{
+		if (!Voice.Component->IsPlaying())
+		{
+			Voice.Weapon.Reset();
+			FreeVoice = FreeVoice ? FreeVoice : &Voice;
+			continue;
+		}
+
+		if (Voice.Weapon.Get() == Weapon)
+		{
+			return &Voice;
+		}
+
+		if (WeakestVoice == nullptr || Voice.Priority < WeakestVoice->Priority)
+		{
+			WeakestVoice = &Voice;
+		}
+	}
+
+	if (FreeVoice != nullptr)
+	{
+		return FreeVoice;
+	}
+	return WeakestVoice != nullptr && WeakestVoice->Priority < Priority ? WeakestVoice : nullptr;
+}
+
+void UTP_WeaponAudioSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Shots merged into another one this frame count as culled too
+	int32 CulledThisFrame = NumMergedThisFrame;
+	NumMergedThisFrame = 0;
+
+	if (PendingShots.Num() > 0)
+	{
+		PlayPendingShots(CulledThisFrame);
+	}
+	NumCulled += CulledThisFrame;
+
+	// Counted every frame, voices finish while nothing is firing too
+	NumActiveVoices = 0;
+	for (const FVoice& Voice : Voices)
+	{
+		NumActiveVoices += Voice.Component->IsPlaying() ? 1 : 0;
+	}
+
+	SET_DWORD_STAT(STAT_TPWeaponAudioVoices, NumActiveVoices);
+	SET_DWORD_STAT(STAT_TPWeaponAudioCulled, CulledThisFrame);
+}
+
+void UTP_WeaponAudioSubsystem::PlayPendingShots(int32& CulledThisFrame)
+{
+	EnsurePool();
+
+	ListenerLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController != nullptr && PlayerController->IsLocalController())
+		{
+			FVector ListenerLocation, FrontDir, RightDir;
+			PlayerController->GetAudioListenerPosition(ListenerLocation, FrontDir, RightDir);
+			ListenerLocations.Add(ListenerLocation);
+		}
+	}
+
+	// Everything is culled before a voice is touched, so the audio thread only ever sees the pool
+	for (int32 Index = PendingShots.Num() - 1; Index >= 0; --Index)
+	{
+		FPendingShot& Shot = PendingShots[Index];
+		const float Distance = GetListenerDistance(Shot.Location);
+		if (!Shot.Weapon.IsValid() || (Shot.Priority < LocalWeaponPriority && Distance > MaxAudibleDistance))
+		{
+			PendingShots.RemoveAtSwap(Index, 1, false);
+			++CulledThisFrame;
+			continue;
+		}
+
+		Shot.Priority += 1.f - Distance / MaxAudibleDistance;
+	}
+
+	PendingShots.Sort([](const FPendingShot& A, const FPendingShot& B) { return A.Priority > B.Priority; });
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 Index = 0; Index < PendingShots.Num(); ++Index)
+	{
+		const FPendingShot& Shot = PendingShots[Index];
+		FVoice* Voice = FindVoice(Shot.Weapon.Get(), Shot.Priority);
+		if (Voice == nullptr)
+		{
+			// Shots are sorted, nothing after this one can take a voice either
+			CulledThisFrame += PendingShots.Num() - Index;
+			break;
+		}
+
+		Voice->Component->SetWorldLocation(Shot.Location);
+		if (Voice->Weapon.Get() == Shot.Weapon.Get() && Voice->Component->IsPlaying())
+		{
+			// Rapid fire keeps one voice per weapon; it only restarts once the previous shot's attack has played out
+			Voice->Priority = Shot.Priority;
+			if (Now - Voice->StartTime < MinRetriggerInterval)
+			{
+				++CulledThisFrame;
+				continue;
+			}
+		}
+
+		Voice->Weapon = Shot.Weapon;
+		Voice->Priority = Shot.Priority;
+		Voice->StartTime = Now;
+		Voice->Component->SetSound(Shot.Sound);
+		Voice->Component->Play();
+		++NumPlayed;
+	}
+
+	PendingShots.Reset();
+}
+
+TStatId UTP_WeaponAudioSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTP_WeaponAudioSubsystem, STATGROUP_Tickables);
+}
+
+static FAutoConsoleCommandWithWorld GTPWeaponAudioStatsCommand(
+	TEXT("TP.WeaponAudio.Stats"),
+	TEXT("Logs how many weapon shots were played, coalesced or culled"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UTP_WeaponAudioSubsystem* Subsystem = World->GetSubsystem<UTP_WeaponAudioSubsystem>())
+		{
+			UE_LOG(LogTPWeaponAudio, Display, TEXT("%d shots requested, %d played, %d coalesced or culled, %d of %d voices active"),
+				Subsystem->GetNumRequested(), Subsystem->GetNumPlayed(), Subsystem->GetNumCulled(), Subsystem->GetNumActiveVoices(), Subsystem->MaxVoices);
+		}
+	}));
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TP_WeaponAudioSubsystem.generated.h"
+
+class UAudioComponent;
+class USoundBase;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPWeaponAudio, Log, All);
+
+/**
+ * Plays weapon fire through a fixed pool of audio components.
+ *
+ * Every weapon owns at most one voice: shots fired while its voice is still playing retrigger it instead of starting
+ * another one, and several shots from the same weapon in one frame collapse into one. Before a voice is handed out,
+ * shots are culled by distance to the closest listener and by the voice limit, with the local player's own weapon first,
+ * so the number of live voices stays bounded no matter how many bots are firing.
+ */
+UCLASS(config=Game)
+class THIRDYEARPROJECT_API UTP_WeaponAudioSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Pooled voices, also the hard limit on simultaneous weapon sounds */
+	UPROPERTY(config)
+	int32 MaxVoices = 16;
+
+	/** Shots farther than this from every listener are dropped */
+	UPROPERTY(config)
+	float MaxAudibleDistance = 5000.f;
+
+	/** A weapon's voice younger than this is not restarted, the new shot is absorbed into the one already playing */
+	UPROPERTY(config)
+	float MinRetriggerInterval = 0.05f;
+
+	/** Queues a shot; voices are assigned once per frame in Tick */
+	void PlayWeaponFire(const UObject* Weapon, USoundBase* Sound, const FVector& Location, bool bLocalPlayer);
+
+	/** Shots requested / played / culled since the world started */
+	int32 GetNumRequested() const { return NumRequested; }
+	int32 GetNumPlayed() const { return NumPlayed; }
+	int32 GetNumCulled() const { return NumCulled; }
+
+	/** Pooled voices that were playing at the end of last frame */
+	int32 GetNumActiveVoices() const { return NumActiveVoices; }
+
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+	// USubsystem implementation End
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// FTickableGameObject implementation End
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FPendingShot
+	{
+		TWeakObjectPtr<const UObject> Weapon;
+		USoundBase* Sound = nullptr;
+		FVector Location = FVector::ZeroVector;
+		float Priority = 0.f;
+	};
+
+	struct FVoice
+	{
+		UAudioComponent* Component = nullptr;
+		TWeakObjectPtr<const UObject> Weapon;
+		double StartTime = 0.0;
+		float Priority = 0.f;
+	};
+
+	/** Creates the pooled components on first use */
+	void EnsurePool();
+
+	/** Returns the voice already playing for Weapon, else a free voice, else the least important voice below Priority */
+	FVoice* FindVoice(const UObject* Weapon, float Priority);
+
+	/** Distance to the closest local listener, or 0 when there is no listener to cull against */
+	float GetListenerDistance(const FVector& Location) const;
+
+	/** Culls and plays this frame's shots, adding the ones that got no voice to CulledThisFrame */
+	void PlayPendingShots(int32& CulledThisFrame);
+
+	TArray<FPendingShot> PendingShots;
+	TArray<FVoice> Voices;
+
+	/** Keeps the pooled components alive */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAudioComponent>> PooledComponents;
+
+	TArray<FVector, TInlineAllocator<4>> ListenerLocations;
+
+	int32 NumRequested = 0;
+	int32 NumPlayed = 0;
+	int32 NumCulled = 0;
+	int32 NumActiveVoices = 0;
+
+	/** Shots folded into another shot from the same weapon since the last Tick */
+	int32 NumMergedThisFrame = 0;
+};
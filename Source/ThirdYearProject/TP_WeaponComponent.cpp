@@ -7,14 +7,22 @@
 #include "GameFramework/PlayerController.h"
 #include "Camera/PlayerCameraManager.h"
 #include "Kismet/GameplayStatics.h"
-#include "EnhancedInputComponent.h"
-#include "EnhancedInputSubsystems.h"
+#include "TP_AnimationBudgetSubsystem.h"
+#include "TP_WeaponAudioSubsystem.h"
+#include "TP_HitscanSubsystem.h"
+#include "TP_WeaponInventoryComponent.h"
 
 // Sets default values for this component's properties
 UTP_WeaponComponent::UTP_WeaponComponent()
 {
 	// Default offset from the character location for projectiles to spawn
 	MuzzleOffset = FVector(100.0f, 0.0f, 10.0f);
+
+	// Projectile weapons unless the blueprint says otherwise
+	FireMode = ETP_FireMode::Projectile;
+	PelletsPerShot = 1;
+	SpreadAngle = 0.0f;
+	HitscanRange = 10000.0f;
 }
 
 
@@ -25,39 +33,61 @@ void UTP_WeaponComponent::Fire()
 		return;
 	}
 
-	// Try and fire a projectile
-	if (ProjectileClass != nullptr)
+	UWorld* const World = GetWorld();
+
+	// Aim along the camera for players, along the control rotation for bots
+	FRotator SpawnRotation = Character->GetControlRotation();
+	if (APlayerController* PlayerController = Cast<APlayerController>(Character->GetController()))
 	{
-		UWorld* const World = GetWorld();
-		if (World != nullptr)
+		SpawnRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
+	}
+	// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
+	const FVector SpawnLocation = GetOwner()->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
+
+	if (FireMode == ETP_FireMode::Hitscan)
+	{
+		// Only queued here, the hitscan subsystem traces every weapon's pellets together at the end of the frame
+		if (UTP_HitscanSubsystem* Hitscan = World->GetSubsystem<UTP_HitscanSubsystem>())
 		{
-			APlayerController* PlayerController = Cast<APlayerController>(Character->GetController());
-			const FRotator SpawnRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
-			// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
-			const FVector SpawnLocation = GetOwner()->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
-	
-			//Set Spawn Collision Handling Override
-			FActorSpawnParameters ActorSpawnParams;
-			ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-			
-	
-			// Spawn the projectile at the muzzle
-			World->SpawnActor<AThirdYearProjectProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
+			const float SpreadRadians = FMath::DegreesToRadians(SpreadAngle);
+			for (int32 Pellet = 0; Pellet < PelletsPerShot; ++Pellet)
+			{
+				const FVector Direction = SpreadRadians > 0.0f ? FMath::VRandCone(SpawnRotation.Vector(), SpreadRadians) : SpawnRotation.Vector();
+				Hitscan->QueueShot(SpawnLocation, SpawnLocation + Direction * HitscanRange, Character);
+			}
 		}
 	}
+	// Try and fire a projectile
+	else if (ProjectileClass != nullptr)
+	{
+		//Set Spawn Collision Handling Override
+		FActorSpawnParameters ActorSpawnParams;
+		ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		// Spawn the projectile at the muzzle
+		World->SpawnActor<AThirdYearProjectProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
+	}
 	
-	// Try and play the sound if specified
+	// Try and play the sound if specified, through the pooled weapon voices rather than a new one-shot component per shot
 	if (FireSound != nullptr)
 	{
-		UGameplayStatics::PlaySoundAtLocation(this, FireSound, Character->GetActorLocation());
+		if (UTP_WeaponAudioSubsystem* WeaponAudio = GetWorld()->GetSubsystem<UTP_WeaponAudioSubsystem>())
+		{
+			WeaponAudio->PlayWeaponFire(this, FireSound, Character->GetActorLocation(), Character->IsLocallyControlled() && Character->IsPlayerControlled());
+		}
+		else
+		{
+			UGameplayStatics::PlaySoundAtLocation(this, FireSound, Character->GetActorLocation());
+		}
 	}
 	
 	// Try and play a firing animation if specified
 	if (FireAnimation != nullptr)
 	{
 		// Get the animation object for the arms mesh
+		// Nobody sees another character's first person arms, don't start a montage on them
 		UAnimInstance* AnimInstance = Character->GetMesh1P()->GetAnimInstance();
-		if (AnimInstance != nullptr)
+		if (AnimInstance != nullptr && (Character->IsLocallyControlled() || Character->GetMesh1P()->WasRecentlyRendered()))
 		{
 			AnimInstance->Montage_Play(FireAnimation, 1.f);
 		}
@@ -66,50 +96,56 @@ void UTP_WeaponComponent::Fire()
 
 void UTP_WeaponComponent::AttachWeapon(AThirdYearProjectCharacter* TargetCharacter)
 {
-	Character = TargetCharacter;
+	// Check that the character is valid, and that this weapon isn't carried yet
+	if (TargetCharacter == nullptr || Character == TargetCharacter)
+	{
+		return;
+	}
 
-	// Check that the character is valid, and has no rifle yet
-	if (Character == nullptr || Character->GetHasRifle())
+	// The inventory owns the fire input, weapons that don't fit stay where they are
+	UTP_WeaponInventoryComponent* Inventory = TargetCharacter->GetWeaponInventory();
+	if (Inventory == nullptr || Inventory->GetNumWeapons() >= Inventory->MaxWeapons)
 	{
 		return;
 	}
+	Character = TargetCharacter;
 
-	// Attach the weapon to the First Person Character
+	// Attach the weapon to the First Person Character, it stays attached while carried and is only hidden when not held
 	FAttachmentTransformRules AttachmentRules(EAttachmentRule::SnapToTarget, true);
 	AttachToComponent(Character->GetMesh1P(), AttachmentRules, FName(TEXT("GripPoint")));
 	
 	// switch bHasRifle so the animation blueprint can switch to another animation set
 	Character->SetHasRifle(true);
 
-	// Set up action bindings
-	if (APlayerController* PlayerController = Cast<APlayerController>(Character->GetController()))
+	// The pickup was dormant on servers; carried, it moves with the character, so it has to leave the grid's static
+	// lists and replicate like any other moving actor again
+	if (GetOwner()->HasAuthority() && GetOwner()->NetDormancy != DORM_Awake)
 	{
-		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
-		{
-			// Set the priority of the mapping to 1, so that it overrides the Jump action with the Fire action when using touch input
-			Subsystem->AddMappingContext(FireMappingContext, 1);
-		}
+		GetOwner()->SetNetDormancy(DORM_Awake);
+	}
 
-		if (UEnhancedInputComponent* EnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerController->InputComponent))
-		{
-			// Fire
-			EnhancedInputComponent->BindAction(FireAction, ETriggerEvent::Triggered, this, &UTP_WeaponComponent::Fire);
-		}
+	// The weapon follows the same animation budget as the arms it is attached to
+	if (UTP_AnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UTP_AnimationBudgetSubsystem>())
+	{
+		AnimationBudget->ConfigureComponent(this, Character);
 	}
+
+	// Set up action bindings, once per weapon rather than on every switch
+	Inventory->AddWeapon(this);
 }
 
 void UTP_WeaponComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	Super::EndPlay(EndPlayReason);
+
 	if (Character == nullptr)
 	{
 		return;
 	}
 
-	if (APlayerController* PlayerController = Cast<APlayerController>(Character->GetController()))
+	// The inventory removes the mapping contexts when it goes, until then other weapons still use them
+	if (UTP_WeaponInventoryComponent* Inventory = Character->GetWeaponInventory())
 	{
-		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
-		{
-			Subsystem->RemoveMappingContext(FireMappingContext);
-		}
+		Inventory->RemoveWeapon(this);
 	}
-}
\ No newline at end of file
+}
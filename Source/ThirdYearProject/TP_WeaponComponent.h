@@ -3,13 +3,23 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Components/SkeletalMeshComponent.h"
+#include "SkeletalMeshComponentBudgeted.h"
 #include "TP_WeaponComponent.generated.h"
 
 class AThirdYearProjectCharacter;
 
+/** How a weapon resolves its shots */
+UENUM(BlueprintType)
+enum class ETP_FireMode : uint8
+{
+	/** Spawns a ProjectileClass actor per shot */
+	Projectile,
+	/** Instant traces, resolved together with every other weapon's at the end of the frame */
+	Hitscan
+};
+
 UCLASS(Blueprintable, BlueprintType, ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
-class THIRDYEARPROJECT_API UTP_WeaponComponent : public USkeletalMeshComponent
+class THIRDYEARPROJECT_API UTP_WeaponComponent : public USkeletalMeshComponentBudgeted
 {
 	GENERATED_BODY()
 
@@ -18,6 +28,22 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category=Projectile)
 	TSubclassOf<class AThirdYearProjectProjectile> ProjectileClass;
 
+	/** Projectile or hitscan */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Gameplay)
+	ETP_FireMode FireMode;
+
+	/** Hitscan traces per shot, more than one makes a shotgun */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Gameplay, meta=(ClampMin=1, EditCondition="FireMode==ETP_FireMode::Hitscan"))
+	int32 PelletsPerShot;
+
+	/** Half-angle of the cone hitscan pellets are spread over, in degrees */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Gameplay, meta=(ClampMin=0, EditCondition="FireMode==ETP_FireMode::Hitscan"))
+	float SpreadAngle;
+
+	/** How far hitscan traces reach */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Gameplay, meta=(EditCondition="FireMode==ETP_FireMode::Hitscan"))
+	float HitscanRange;
+
 	/** Sound to play each time we fire */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
 	USoundBase* FireSound;
@@ -41,11 +67,11 @@ public:
 	/** Sets default values for this component's properties */
 	UTP_WeaponComponent();
 
-	/** Attaches the actor to a FirstPersonCharacter */
+	/** Attaches the actor to a FirstPersonCharacter and adds it to the character's weapon inventory */
 	UFUNCTION(BlueprintCallable, Category="Weapon")
 	void AttachWeapon(AThirdYearProjectCharacter* TargetCharacter);
 
-	/** Make the weapon Fire a Projectile */
+	/** Make the weapon Fire a Projectile, or hitscan pellets */
 	UFUNCTION(BlueprintCallable, Category="Weapon")
 	void Fire();
 
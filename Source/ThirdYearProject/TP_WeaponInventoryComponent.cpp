@@ -0,0 +1,361 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_WeaponInventoryComponent.h"
+#include "ThirdYearProject.h"
+#include "ThirdYearProjectCharacter.h"
+#include "TP_WeaponComponent.h"
+#include "EnhancedInputComponent.h"
+#include "EnhancedInputSubsystems.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformMemory.h"
+#include "RenderingThread.h"
+#include "UObject/UObjectArray.h"
+
+DEFINE_LOG_CATEGORY(LogTPWeaponInventory);
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Swap"), STAT_TPWeaponSwap, STATGROUP_ThirdYearProject);
+
+namespace TPWeaponInventory
+{
+	/** Frames switched before the stress test takes its starting memory reading */
+	constexpr int32 StressWarmupFrames = 30;
+
+	/** Malloc and realloc calls made so far by the whole process, 0 when the allocator keeps no stats (UE_STATS off) */
+	static uint64 GetMallocCalls()
+	{
+		FGenericMemoryStats Stats;
+		GMalloc->GetAllocatorStats(Stats);
+
+		uint64 Calls = 0;
+		for (const auto& Stat : Stats.Data)
+		{
+			const FStringView Name(Stat.Key);
+			if (Name == TEXT("Total Malloc Calls") || Name == TEXT("Total Realloc Calls"))
+			{
+				Calls += Stat.Value;
+			}
+		}
+		return Calls;
+	}
+}
+
+UTP_WeaponInventoryComponent::UTP_WeaponInventoryComponent()
+{
+	// Only ticks while a swap stress test runs
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+AThirdYearProjectCharacter* UTP_WeaponInventoryComponent::GetCharacter() const
+{
+	return Cast<AThirdYearProjectCharacter>(GetOwner());
+}
+
+void UTP_WeaponInventoryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Weapons.Reserve(MaxWeapons);
+
+	AThirdYearProjectCharacter* Character = GetCharacter();
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	for (const TSubclassOf<UTP_WeaponComponent>& WeaponClass : StartingWeapons)
+	{
+		if (WeaponClass == nullptr)
+		{
+			continue;
+		}
+
+		UTP_WeaponComponent* Weapon = NewObject<UTP_WeaponComponent>(Character, WeaponClass);
+		Weapon->RegisterComponent();
+		Weapon->AttachWeapon(Character);
+	}
+}
+
+void UTP_WeaponInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	const AThirdYearProjectCharacter* Character = GetCharacter();
+	const APlayerController* PlayerController = Character ? Cast<APlayerController>(Character->GetController()) : nullptr;
+	if (PlayerController != nullptr)
+	{
+		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
+		{
+			for (const UInputMappingContext* Context : AddedContexts)
+			{
+				Subsystem->RemoveMappingContext(Context);
+			}
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UTP_WeaponInventoryComponent::AddWeapon(UTP_WeaponComponent* Weapon)
+{
+	if (Weapon == nullptr || Weapons.Contains(Weapon))
+	{
+		return Weapon != nullptr;
+	}
+
+	if (Weapons.Num() >= MaxWeapons)
+	{
+		UE_LOG(LogTPWeaponInventory, Warning, TEXT("%s can't carry more than %d weapons"), *GetNameSafe(GetOwner()), MaxWeapons);
+		return false;
+	}
+
+	Weapons.Add(Weapon);
+	BindWeaponInput(Weapon);
+
+	if (ActiveIndex == INDEX_NONE)
+	{
+		ActiveIndex = Weapons.Num() - 1;
+	}
+	else
+	{
+		// Carried but not held
+		Weapon->SetVisibility(false);
+		Weapon->Deactivate();
+	}
+	return true;
+}
+
+void UTP_WeaponInventoryComponent::RemoveWeapon(UTP_WeaponComponent* Weapon)
+{
+	const int32 Index = Weapons.Find(Weapon);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	Weapons.RemoveAt(Index, 1, false);
+	if (Index < ActiveIndex)
+	{
+		--ActiveIndex;
+	}
+	else if (Index == ActiveIndex)
+	{
+		ActiveIndex = INDEX_NONE;
+		if (Weapons.Num() > 0)
+		{
+			SelectWeapon(Index % Weapons.Num());
+		}
+	}
+
+	if (Weapons.Num() == 0)
+	{
+		if (AThirdYearProjectCharacter* Character = GetCharacter())
+		{
+			Character->SetHasRifle(false);
+		}
+	}
+}
+
+void UTP_WeaponInventoryComponent::SelectWeapon(int32 Index)
+{
+	if (!Weapons.IsValidIndex(Index) || Index == ActiveIndex)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_TPWeaponSwap);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// Everything stays attached and bound, switching is only visibility and activation
+	UTP_WeaponComponent* Previous = GetActiveWeapon();
+	if (Previous != nullptr)
+	{
+		Previous->SetVisibility(false);
+		Previous->Deactivate();
+	}
+
+	ActiveIndex = Index;
+	UTP_WeaponComponent* Next = Weapons[ActiveIndex];
+	Next->SetVisibility(true);
+	Next->Activate();
+
+	LastSwapMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+}
+
+void UTP_WeaponInventoryComponent::NextWeapon()
+{
+	if (Weapons.Num() > 1)
+	{
+		SelectWeapon((ActiveIndex + 1) % Weapons.Num());
+	}
+}
+
+void UTP_WeaponInventoryComponent::Fire()
+{
+	if (UTP_WeaponComponent* Weapon = GetActiveWeapon())
+	{
+		Weapon->Fire();
+	}
+}
+
+void UTP_WeaponInventoryComponent::BindInput()
+{
+	BindWeaponInput(nullptr);
+	for (const UTP_WeaponComponent* Weapon : Weapons)
+	{
+		BindWeaponInput(Weapon);
+	}
+}
+
+void UTP_WeaponInventoryComponent::BindWeaponInput(const UTP_WeaponComponent* Weapon)
+{
+	const AThirdYearProjectCharacter* Character = GetCharacter();
+	const APlayerController* PlayerController = Character ? Cast<APlayerController>(Character->GetController()) : nullptr;
+	UEnhancedInputComponent* EnhancedInputComponent = PlayerController ? Cast<UEnhancedInputComponent>(PlayerController->InputComponent) : nullptr;
+	if (EnhancedInputComponent == nullptr)
+	{
+		return;
+	}
+
+	// A new controller has none of the old bindings
+	if (BoundInputComponent.Get() != EnhancedInputComponent)
+	{
+		BoundInputComponent = EnhancedInputComponent;
+		BoundActions.Reset();
+		AddedContexts.Reset();
+
+		if (NextWeaponAction != nullptr)
+		{
+			EnhancedInputComponent->BindAction(NextWeaponAction, ETriggerEvent::Started, this, &UTP_WeaponInventoryComponent::NextWeapon);
+		}
+	}
+
+	if (Weapon == nullptr)
+	{
+		return;
+	}
+
+	if (Weapon->FireMappingContext != nullptr && !AddedContexts.Contains(Weapon->FireMappingContext))
+	{
+		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
+		{
+			// Set the priority of the mapping to 1, so that it overrides the Jump action with the Fire action when using touch input
+			Subsystem->AddMappingContext(Weapon->FireMappingContext, 1);
+			AddedContexts.Add(Weapon->FireMappingContext);
+		}
+	}
+
+	// Weapons sharing a FireAction share the binding
+	if (Weapon->FireAction != nullptr && !BoundActions.Contains(Weapon->FireAction))
+	{
+		EnhancedInputComponent->BindAction(Weapon->FireAction, ETriggerEvent::Triggered, this, &UTP_WeaponInventoryComponent::Fire);
+		BoundActions.Add(Weapon->FireAction);
+	}
+}
+
+void UTP_WeaponInventoryComponent::StartSwapStress(int32 NumFrames)
+{
+	if (Weapons.Num() < 2)
+	{
+		UE_LOG(LogTPWeaponInventory, Error, TEXT("Swap stress needs at least two carried weapons, %s has %d"), *GetNameSafe(GetOwner()), Weapons.Num());
+		return;
+	}
+
+	Stress = FSwapStress();
+	Stress.WarmupFramesLeft = TPWeaponInventory::StressWarmupFrames;
+	Stress.FramesLeft = FMath::Max(NumFrames, 1);
+
+	// Reading the allocator's counters allocates too, measure that once so it can be taken off every swap
+	const uint64 FirstReading = TPWeaponInventory::GetMallocCalls();
+	Stress.ReadingMallocCalls = TPWeaponInventory::GetMallocCalls() - FirstReading;
+
+	SetComponentTickEnabled(true);
+}
+
+void UTP_WeaponInventoryComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (Stress.FramesLeft <= 0)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	// The switch only marks the meshes' render state dirty, the rebuild happens with the end of frame updates (in
+	// parallel) and on the render thread. Send and flush everything else pending first, then measure the switch
+	// through its own rebuild. Only the stress test stalls like this, a normal switch leaves it to the end of the frame
+	UWorld* World = GetWorld();
+	World->SendAllEndOfFrameUpdates();
+	FlushRenderingCommands();
+
+	const uint64 MallocCallsBefore = TPWeaponInventory::GetMallocCalls();
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	NextWeapon();
+	World->SendAllEndOfFrameUpdates();
+	const double SwapMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	FlushRenderingCommands();
+	const uint64 MallocCalls = TPWeaponInventory::GetMallocCalls() - MallocCallsBefore;
+
+	if (Stress.WarmupFramesLeft > 0)
+	{
+		// Readings start once the first switches have settled
+		if (--Stress.WarmupFramesLeft == 0)
+		{
+			Stress.StartUsedPhysical = Stress.PeakUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+			Stress.StartObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		}
+		return;
+	}
+
+	++Stress.NumSwaps;
+	Stress.TotalMs += SwapMs;
+	Stress.MaxMs = FMath::Max(Stress.MaxMs, SwapMs);
+	Stress.MallocCalls += MallocCalls > Stress.ReadingMallocCalls ? MallocCalls - Stress.ReadingMallocCalls : 0;
+	Stress.PeakUsedPhysical = FMath::Max(Stress.PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+
+	if (--Stress.FramesLeft == 0)
+	{
+		FinishSwapStress();
+	}
+}
+
+void UTP_WeaponInventoryComponent::FinishSwapStress()
+{
+	const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	const double ToKB = 1.0 / 1024.0;
+
+	UE_LOG(LogTPWeaponInventory, Display, TEXT("%d swaps between %d weapons: %.4f ms average, %.4f ms max, game thread render state rebuild included"),
+		Stress.NumSwaps, Weapons.Num(), Stress.NumSwaps > 0 ? Stress.TotalMs / Stress.NumSwaps : 0.0, Stress.MaxMs);
+	if (TPWeaponInventory::GetMallocCalls() > 0)
+	{
+		UE_LOG(LogTPWeaponInventory, Display, TEXT("  %.1f allocations per swap (process-wide malloc/realloc calls during the swap, render thread included)"),
+			Stress.NumSwaps > 0 ? static_cast<double>(Stress.MallocCalls) / Stress.NumSwaps : 0.0);
+	}
+	else
+	{
+		UE_LOG(LogTPWeaponInventory, Display, TEXT("  allocations not counted, the allocator keeps no call stats in this build"));
+	}
+	UE_LOG(LogTPWeaponInventory, Display, TEXT("  process memory %+.1f KB (peak %+.1f KB), UObjects %+d"),
+		(static_cast<double>(UsedPhysical) - Stress.StartUsedPhysical) * ToKB,
+		(static_cast<double>(Stress.PeakUsedPhysical) - Stress.StartUsedPhysical) * ToKB,
+		GUObjectArray.GetObjectArrayNumMinusAvailable() - Stress.StartObjects);
+
+	SetComponentTickEnabled(false);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPWeaponSwapStressCommand(
+	TEXT("TP.Weapon.SwapStress"),
+	TEXT("Switches the local player's weapon every frame and logs switch cost, allocations and memory growth. Usage: TP.Weapon.SwapStress [Frames=1000]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PlayerController = World->GetFirstPlayerController();
+		AThirdYearProjectCharacter* Character = PlayerController ? Cast<AThirdYearProjectCharacter>(PlayerController->GetPawn()) : nullptr;
+		if (UTP_WeaponInventoryComponent* Inventory = Character ? Character->GetWeaponInventory() : nullptr)
+		{
+			Inventory->StartSwapStress(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000);
+		}
+	}));
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "TP_WeaponInventoryComponent.generated.h"
+
+class AThirdYearProjectCharacter;
+class UEnhancedInputComponent;
+class UInputAction;
+class UInputMappingContext;
+class UTP_WeaponComponent;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPWeaponInventory, Log, All);
+
+/**
+ * Every weapon the owning character carries, attached to the arms once and kept there.
+ *
+ * A weapon is set up when it is added (attached to GripPoint, animation budget, input), never again: switching only
+ * hides and deactivates the current weapon and shows and activates the next. Fire input is bound once to this
+ * component, which forwards it to whichever weapon is active, so a switch touches no input bindings or mapping
+ * contexts. Hiding and showing a mesh still rebuilds its render proxy, which allocates; that is left to the end of
+ * frame updates like any other render state change.
+ *
+ * TP.Weapon.SwapStress switches the local player's weapons every frame and logs the switch cost, allocations per switch
+ * and memory growth. It sends the end of frame updates and flushes the render thread around each switch, so the
+ * proxy rebuild is part of what it measures.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class THIRDYEARPROJECT_API UTP_WeaponInventoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UTP_WeaponInventoryComponent();
+
+	/** Weapons created and carried from BeginPlay, the first one is held */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Weapon)
+	TArray<TSubclassOf<UTP_WeaponComponent>> StartingWeapons;
+
+	/** Most weapons carried at once, the inventory's storage is reserved for this many */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Weapon, meta=(ClampMin=1))
+	int32 MaxWeapons = 4;
+
+	/** Switches to the next carried weapon, optional */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input)
+	UInputAction* NextWeaponAction;
+
+	/** Attaches Weapon to the owning character and binds its input; it is held if nothing else is. Returns false when full */
+	bool AddWeapon(UTP_WeaponComponent* Weapon);
+
+	/** Drops a weapon that is going away, holding the next one if it was active */
+	void RemoveWeapon(UTP_WeaponComponent* Weapon);
+
+	/** Holds the weapon at Index */
+	UFUNCTION(BlueprintCallable, Category=Weapon)
+	void SelectWeapon(int32 Index);
+
+	UFUNCTION(BlueprintCallable, Category=Weapon)
+	void NextWeapon();
+
+	/** Fires the held weapon, the one handler every weapon's FireAction is bound to */
+	UFUNCTION(BlueprintCallable, Category=Weapon)
+	void Fire();
+
+	UFUNCTION(BlueprintCallable, Category=Weapon)
+	UTP_WeaponComponent* GetActiveWeapon() const { return Weapons.IsValidIndex(ActiveIndex) ? Weapons[ActiveIndex] : nullptr; }
+
+	int32 GetNumWeapons() const { return Weapons.Num(); }
+
+	/** (Re)binds input for every carried weapon, call when the owner's controller changes */
+	void BindInput();
+
+	/** Switches weapon every frame for NumFrames frames, then logs switch cost, allocations and memory growth */
+	void StartSwapStress(int32 NumFrames);
+
+	/** Game thread time of the last switch, without the render state rebuild at the end of the frame */
+	double GetLastSwapMs() const { return LastSwapMs; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	AThirdYearProjectCharacter* GetCharacter() const;
+
+	/** Adds Weapon's mapping context and binds its FireAction to Fire unless already done for this input component; null only binds NextWeaponAction */
+	void BindWeaponInput(const UTP_WeaponComponent* Weapon);
+
+	void FinishSwapStress();
+
+	UPROPERTY(Transient)
+	TArray<UTP_WeaponComponent*> Weapons;
+
+	int32 ActiveIndex = INDEX_NONE;
+
+	/** Input component everything below was bound to, a new controller brings a new one */
+	TWeakObjectPtr<UEnhancedInputComponent> BoundInputComponent;
+	TArray<const UInputAction*> BoundActions;
+	TArray<const UInputMappingContext*> AddedContexts;
+
+	double LastSwapMs = 0.0;
+
+	struct FSwapStress
+	{
+		int32 WarmupFramesLeft = 0;
+		int32 FramesLeft = 0;
+		int32 NumSwaps = 0;
+		double TotalMs = 0.0;
+		double MaxMs = 0.0;
+		uint64 StartUsedPhysical = 0;
+		uint64 PeakUsedPhysical = 0;
+		int32 StartObjects = 0;
+		uint64 MallocCalls = 0;
+
+		/** Allocations made by reading the allocator's counters, taken off every swap */
+		uint64 ReadingMallocCalls = 0;
+	};
+	FSwapStress Stress;
+};
@@ -8,6 +8,9 @@ public class ThirdYearProject : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "NavigationSystem", "AIModule", "PhysicsCore", "Chaos", "AnimationBudgetAllocator", "ReplicationGraph", "RenderCore" });
+
+		// Headers live next to the sources, expose them to the editor module
+		PublicIncludePaths.Add(ModuleDirectory);
 	}
 }
@@ -3,3 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/** Gameplay performance counters, shown with 'stat ThirdYearProject' */
+DECLARE_STATS_GROUP(TEXT("ThirdYearProject"), STATGROUP_ThirdYearProject, STATCAT_Advanced);
@@ -2,6 +2,18 @@
 
 #include "ThirdYearProjectCharacter.h"
 #include "ThirdYearProjectProjectile.h"
+#include "TP_PredictiveStreamingComponent.h"
+#include "TP_ParkourMovementModel.h"
+#include "TP_ParkourNavLinkActor.h"
+#include "TP_ParkourAIController.h"
+#include "TP_CheckpointSubsystem.h"
+#include "TP_GhostRecorderComponent.h"
+#include "TP_AnimationBudgetSubsystem.h"
+#include "TP_SceneQuerySubsystem.h"
+#include "TP_ReplaySubsystem.h"
+#include "TP_FrameBudgetSubsystem.h"
+#include "TP_WeaponInventoryComponent.h"
+#include "SkeletalMeshComponentBudgeted.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -18,7 +30,8 @@ DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 //////////////////////////////////////////////////////////////////////////
 // AThirdYearProjectCharacter
 
-AThirdYearProjectCharacter::AThirdYearProjectCharacter()
+AThirdYearProjectCharacter::AThirdYearProjectCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName))
 {
 	// Character doesnt have a rifle at start
 	bHasRifle = false;
@@ -33,7 +46,7 @@ AThirdYearProjectCharacter::AThirdYearProjectCharacter()
 	FirstPersonCameraComponent->bUsePawnControlRotation = true;
 
 	// Create a mesh component that will be used when being viewed from a '1st person' view 
-	Mesh1P = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("CharacterMesh1P"));
+	Mesh1P = CreateDefaultSubobject<USkeletalMeshComponentBudgeted>(TEXT("CharacterMesh1P"));
 	Mesh1P->SetOnlyOwnerSee(true);
 	Mesh1P->SetupAttachment(FirstPersonCameraComponent);
 	Mesh1P->bCastDynamicShadow = false;
@@ -41,6 +54,17 @@ AThirdYearProjectCharacter::AThirdYearProjectCharacter()
 	//Mesh1P->SetRelativeRotation(FRotator(0.9f, -19.19f, 5.2f));
 	Mesh1P->SetRelativeLocation(FVector(-30.f, 0.f, -150.f));
 
+	// Streams World Partition cells ahead of sprints, slides and launches
+	PredictiveStreaming = CreateDefaultSubobject<UTP_PredictiveStreamingComponent>(TEXT("PredictiveStreaming"));
+
+	// Idle until a recording is started
+	GhostRecorder = CreateDefaultSubobject<UTP_GhostRecorderComponent>(TEXT("GhostRecorder"));
+
+	// Starting and picked up weapons, kept attached while carried
+	WeaponInventory = CreateDefaultSubobject<UTP_WeaponInventoryComponent>(TEXT("WeaponInventory"));
+
+	// AI follows parkour nav links with the same moves the builder generated them from
+	AIControllerClass = ATP_ParkourAIController::StaticClass();
 
 	//Movement settings
 	GetCharacterMovement()->JumpZVelocity = 500.0f;
@@ -99,6 +123,39 @@ void AThirdYearProjectCharacter::BeginPlay()
 		}
 	}
 
+	// Wall probes for every character are traced together at the end of each frame
+	if (UTP_SceneQuerySubsystem* SceneQueries = GetWorld()->GetSubsystem<UTP_SceneQuerySubsystem>())
+	{
+		SceneQueries->RegisterCharacter(this);
+	}
+
+	// Recorded into the rolling replay buffer for kill-cams and instant replays
+	if (UTP_ReplaySubsystem* Replay = GetWorld()->GetSubsystem<UTP_ReplaySubsystem>())
+	{
+		Replay->RegisterCharacter(this);
+	}
+
+}
+
+void AThirdYearProjectCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	// Local player meshes run at full rate, bots and remote players are budgeted
+	if (UTP_AnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UTP_AnimationBudgetSubsystem>())
+	{
+		AnimationBudget->ConfigureComponent(Mesh1P, this);
+		AnimationBudget->ConfigureComponent(Cast<USkeletalMeshComponentBudgeted>(GetMesh()), this);
+	}
+
+	// Bots tick less often when the frame budget governor is shedding load
+	if (const UTP_FrameBudgetSubsystem* FrameBudget = GetWorld()->GetSubsystem<UTP_FrameBudgetSubsystem>())
+	{
+		FrameBudget->ConfigureCharacter(this);
+	}
+
+	// Fire input goes through the inventory, bound again only for a new controller
+	WeaponInventory->BindInput();
 }
 
 //////////////////////////////////////////////////////////////////////////// Input
@@ -155,7 +212,7 @@ void AThirdYearProjectCharacter::Jump()
 			StopWallRun();
 
 			// Jump direction: Away from the wall and slightly forward
-			FVector JumpAwayFromWall = WallRunNormal * 600.f + GetActorForwardVector() * 400.f + FVector(0, 0, 800.f);
+			FVector JumpAwayFromWall = FTP_ParkourMovementModel::GetWallJumpVelocity(WallRunNormal, GetActorForwardVector());
 
 			LaunchCharacter(JumpAwayFromWall, true, true);
 
@@ -169,7 +226,7 @@ void AThirdYearProjectCharacter::Jump()
 		else
 		{
 			// Second jump - preserve some velocity
-			FVector JumpVelocity = FVector(GetVelocity().X, GetVelocity().Y, GetCharacterMovement()->JumpZVelocity);
+			FVector JumpVelocity = FTP_ParkourMovementModel::GetDoubleJumpVelocity(GetVelocity(), GetCharacterMovement()->JumpZVelocity);
 			LaunchCharacter(JumpVelocity, false, true);
 		}
 
@@ -182,6 +239,7 @@ void AThirdYearProjectCharacter::Landed(const FHitResult& Hit)
 {
 	Super::Landed(Hit);
 	JumpCount = 0;  // Reset jump count when landing
+	bParkourWallJumpPending = false;
 	UE_LOG(LogTemp, Warning, TEXT("Jumps Reset"));
 }
 
@@ -272,7 +330,7 @@ void AThirdYearProjectCharacter::StartSlide()
 		GetCharacterMovement()->MaxWalkSpeed = SlideSpeed;
 
 		// Lower capsule for sliding effect
-		GetCapsuleComponent()->SetCapsuleHalfHeight(48.f);
+		GetCapsuleComponent()->SetCapsuleHalfHeight(FTP_ParkourMovementModel::SlideCapsuleHalfHeight);
 	}
 }
 
@@ -291,8 +349,7 @@ void AThirdYearProjectCharacter::SlideJump()
 	if (bIsSliding)
 	{
 		// Preserve momentum when jumping out of slide
-		FVector JumpDirection = GetActorForwardVector() * 1.2f + FVector(0, 0, 1);
-		LaunchCharacter(JumpDirection * 800.f, true, true);
+		LaunchCharacter(FTP_ParkourMovementModel::GetSlideJumpVelocity(GetActorForwardVector()), true, true);
 		StopSlide();
 	}
 }
@@ -310,9 +367,19 @@ bool AThirdYearProjectCharacter::GetHasRifle()
 
 bool AThirdYearProjectCharacter::CanWallRun(FVector& OutWallNormal)
 {
+	// Use the batched result when it is still current for where the character is now
+	if (const UTP_SceneQuerySubsystem* SceneQueries = GetWorld()->GetSubsystem<UTP_SceneQuerySubsystem>())
+	{
+		const ETP_ProbeResult BatchedResult = SceneQueries->GetWallProbe(this, OutWallNormal);
+		if (BatchedResult != ETP_ProbeResult::Unknown)
+		{
+			return BatchedResult == ETP_ProbeResult::Hit;
+		}
+	}
+
 	FVector Start = GetActorLocation();
-	FVector RightTraceEnd = Start + (GetActorRightVector() * 100.f); // Check right side
-	FVector LeftTraceEnd = Start - (GetActorRightVector() * 100.f);  // Check left side
+	FVector RightTraceEnd = Start + (GetActorRightVector() * FTP_ParkourMovementModel::WallProbeDistance); // Check right side
+	FVector LeftTraceEnd = Start - (GetActorRightVector() * FTP_ParkourMovementModel::WallProbeDistance);  // Check left side
 
 	FHitResult HitResult;
 	FCollisionQueryParams QueryParams;
@@ -352,19 +419,25 @@ void AThirdYearProjectCharacter::StartWallRun(FVector WallNormal)
         WallRunNormal = WallNormal; // Store the wall normal
 
         // Apply low gravity to the character during wall running
-        GetCharacterMovement()->GravityScale = 0.3f;  
-        GetCharacterMovement()->MaxWalkSpeed = 1000.0f;  // Start with a default wall run speed
+        GetCharacterMovement()->GravityScale = FTP_ParkourMovementModel::WallRunGravityScale;
+        GetCharacterMovement()->MaxWalkSpeed = FTP_ParkourMovementModel::WallRunMaxWalkSpeed;  // Start with a default wall run speed
         JumpCount = 0;
 		UE_LOG(LogTemp, Warning, TEXT("Jumps Reset"));
 
         // Get the direction to move along the wall (cross product with up vector)
-        WallRunDirection = FVector::CrossProduct(WallNormal, FVector::UpVector);
-        WallRunDirection *= (FVector::DotProduct(WallRunDirection, GetActorForwardVector()) > 0) ? 1 : -1;
+        WallRunDirection = FTP_ParkourMovementModel::GetWallRunDirection(WallNormal, GetActorForwardVector());
 
         // Apply initial velocity based on the wall normal and run direction
         FVector WallRunVelocity = WallRunDirection * 800.f + FVector(0, 0, 300.f); // Add vertical lift for smooth wall running
         GetCharacterMovement()->Velocity = WallRunVelocity;  // Apply the calculated velocity to the character
-        LaunchCharacter(WallRunDirection * 1200.0f, true, true);  // Initial jump boost along the wall
+        LaunchCharacter(WallRunDirection * FTP_ParkourMovementModel::WallRunSpeed, true, true);  // Initial jump boost along the wall
+
+        // A parkour link being followed jumps off after the same hold the builder simulated
+        if (bParkourWallJumpPending)
+        {
+            bParkourWallJumpPending = false;
+            GetWorld()->GetTimerManager().SetTimer(ParkourWallJumpTimer, this, &AThirdYearProjectCharacter::ParkourWallJump, FTP_ParkourMovementModel::LinkWallRunHoldTime, false);
+        }
 
         UE_LOG(LogTemp, Warning, TEXT("Wallrun Started"));
     }
@@ -392,4 +465,111 @@ void AThirdYearProjectCharacter::ResetWallRun()
 	UE_LOG(LogTemp, Warning, TEXT("Wallrun Ready Again"));
 }
 
+void AThirdYearProjectCharacter::TraverseParkourLink(const FTP_ParkourLink& Link)
+{
+	const FVector TakeOffVelocity(Link.TakeOffVelocity);
+	const FVector Forward = TakeOffVelocity.GetSafeNormal2D();
+	SetActorRotation(Forward.Rotation());
+
+	// Armed until the next wall-run starts, cleared on landing
+	bParkourWallJumpPending = EnumHasAnyFlags(static_cast<ETP_ParkourMove>(Link.Moves), ETP_ParkourMove::WallJump);
+
+	if (EnumHasAnyFlags(static_cast<ETP_ParkourMove>(Link.Moves), ETP_ParkourMove::SlideJump))
+	{
+		// The link was generated from a slide jump, the launch is the same one SlideJump applies
+		LaunchCharacter(TakeOffVelocity, true, true);
+		JumpCount = 1;
+	}
+	else
+	{
+		GetCharacterMovement()->Velocity = FVector(TakeOffVelocity.X, TakeOffVelocity.Y, GetCharacterMovement()->Velocity.Z);
+		Jump();
 
+		if (EnumHasAnyFlags(static_cast<ETP_ParkourMove>(Link.Moves), ETP_ParkourMove::DoubleJump))
+		{
+			// The builder double jumps at the apex of the first jump
+			const float TimeToApex = GetCharacterMovement()->JumpZVelocity / FMath::Max(-GetCharacterMovement()->GetGravityZ(), UE_KINDA_SMALL_NUMBER);
+			GetWorld()->GetTimerManager().SetTimer(ParkourDoubleJumpTimer, this, &AThirdYearProjectCharacter::ParkourDoubleJump, TimeToApex, false);
+		}
+	}
+}
+
+void AThirdYearProjectCharacter::ParkourDoubleJump()
+{
+	if (GetCharacterMovement()->IsFalling() && !bIsWallRunning)
+	{
+		Jump();
+	}
+}
+
+void AThirdYearProjectCharacter::ParkourWallJump()
+{
+	// The wall may have ended early, the builder doesn't jump then either
+	if (bIsWallRunning)
+	{
+		Jump();
+	}
+}
+
+void AThirdYearProjectCharacter::SaveCheckpointState(FTP_CharacterCheckpoint& OutCheckpoint) const
+{
+	const UCharacterMovementComponent* Movement = GetCharacterMovement();
+
+	OutCheckpoint.CharacterName = GetFName();
+	OutCheckpoint.Transform = GetActorTransform();
+	OutCheckpoint.ControlRotation = GetControlRotation();
+	OutCheckpoint.Velocity = Movement->Velocity;
+	OutCheckpoint.MovementMode = static_cast<uint8>(Movement->MovementMode.GetValue());
+	OutCheckpoint.GravityScale = Movement->GravityScale;
+	OutCheckpoint.MaxWalkSpeed = Movement->MaxWalkSpeed;
+	OutCheckpoint.CapsuleHalfHeight = GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+	OutCheckpoint.JumpCount = JumpCount;
+	OutCheckpoint.bIsSliding = bIsSliding;
+	OutCheckpoint.SlideSpeed = SlideSpeed;
+	OutCheckpoint.SlideDirection = SlideDirection;
+	OutCheckpoint.bIsWallRunning = bIsWallRunning;
+	OutCheckpoint.WallRunDirection = WallRunDirection;
+	OutCheckpoint.WallRunNormal = WallRunNormal;
+	OutCheckpoint.bCanWallRun = bCanWallRun;
+	OutCheckpoint.WallRunCooldownRemaining = FMath::Max(GetWorldTimerManager().GetTimerRemaining(WallRunTimer), 0.f);
+}
+
+void AThirdYearProjectCharacter::RestoreCheckpointState(const FTP_CharacterCheckpoint& Checkpoint)
+{
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+
+	GetCapsuleComponent()->SetCapsuleHalfHeight(Checkpoint.CapsuleHalfHeight);
+	SetActorTransform(Checkpoint.Transform, false, nullptr, ETeleportType::TeleportPhysics);
+	if (Controller != nullptr)
+	{
+		Controller->SetControlRotation(Checkpoint.ControlRotation);
+	}
+
+	Movement->SetMovementMode(static_cast<EMovementMode>(Checkpoint.MovementMode));
+	Movement->Velocity = Checkpoint.Velocity;
+	Movement->PendingLaunchVelocity = FVector::ZeroVector;
+	Movement->GravityScale = Checkpoint.GravityScale;
+	Movement->MaxWalkSpeed = Checkpoint.MaxWalkSpeed;
+
+	JumpCount = Checkpoint.JumpCount;
+	bIsSliding = Checkpoint.bIsSliding;
+	SlideSpeed = Checkpoint.SlideSpeed;
+	SlideDirection = Checkpoint.SlideDirection;
+	bIsWallRunning = Checkpoint.bIsWallRunning;
+	WallRunDirection = Checkpoint.WallRunDirection;
+	WallRunNormal = Checkpoint.WallRunNormal;
+	bCanWallRun = Checkpoint.bCanWallRun;
+
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	TimerManager.ClearTimer(ParkourDoubleJumpTimer);
+	TimerManager.ClearTimer(ParkourWallJumpTimer);
+	bParkourWallJumpPending = false;
+	if (Checkpoint.WallRunCooldownRemaining > 0.f)
+	{
+		TimerManager.SetTimer(WallRunTimer, this, &AThirdYearProjectCharacter::ResetWallRun, Checkpoint.WallRunCooldownRemaining, false);
+	}
+	else
+	{
+		TimerManager.ClearTimer(WallRunTimer);
+	}
+}
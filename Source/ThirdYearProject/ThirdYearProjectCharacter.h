@@ -9,9 +9,15 @@
 
 	class UInputComponent;
 	class USkeletalMeshComponent;
+	class USkeletalMeshComponentBudgeted;
 	class UCameraComponent;
 	class UInputAction;
 	class UInputMappingContext;
+	class UTP_PredictiveStreamingComponent;
+	class UTP_GhostRecorderComponent;
+	class UTP_WeaponInventoryComponent;
+	struct FTP_ParkourLink;
+	struct FTP_CharacterCheckpoint;
 	struct FInputActionValue;
 
 	DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
@@ -23,12 +29,24 @@
 
 		/** Pawn mesh: 1st person view (arms; seen only by self) */
 		UPROPERTY(VisibleDefaultsOnly, Category=Mesh)
-		USkeletalMeshComponent* Mesh1P;
+		USkeletalMeshComponentBudgeted* Mesh1P;
 
 		/** First person camera */
 		UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 		UCameraComponent* FirstPersonCameraComponent;
 
+		/** Requests World Partition cells along the predicted path so high-speed movement doesn't outrun streaming */
+		UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Streaming, meta = (AllowPrivateAccess = "true"))
+		UTP_PredictiveStreamingComponent* PredictiveStreaming;
+
+		/** Records runs as compact ghosts for ghost racing */
+		UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Ghost, meta = (AllowPrivateAccess = "true"))
+		UTP_GhostRecorderComponent* GhostRecorder;
+
+		/** Every weapon carried, attached and bound once so switching is cheap */
+		UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon, meta = (AllowPrivateAccess = "true"))
+		UTP_WeaponInventoryComponent* WeaponInventory;
+
 		/*Movement*/
 		UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
 		UInputMappingContext* DefaultMappingContext;
@@ -49,11 +67,12 @@
 		UInputAction* SlideAction;
 	
 	public:
-		AThirdYearProjectCharacter();
+		AThirdYearProjectCharacter(const FObjectInitializer& ObjectInitializer);
 
 	protected:
 		virtual void BeginPlay();
 		virtual void Tick(float DeltaTime) override;
+		virtual void NotifyControllerChanged() override;
 	public:
 		
 
@@ -104,6 +123,27 @@
 		USkeletalMeshComponent* GetMesh1P() const { return Mesh1P; }
 		/** Returns FirstPersonCameraComponent subobject **/
 		UCameraComponent* GetFirstPersonCameraComponent() const { return FirstPersonCameraComponent; }
+		/** Returns PredictiveStreaming subobject **/
+		UTP_PredictiveStreamingComponent* GetPredictiveStreaming() const { return PredictiveStreaming; }
+		/** Returns GhostRecorder subobject **/
+		UTP_GhostRecorderComponent* GetGhostRecorder() const { return GhostRecorder; }
+		/** Returns WeaponInventory subobject **/
+		UTP_WeaponInventoryComponent* GetWeaponInventory() const { return WeaponInventory; }
+
+		/** Movement state queries */
+		bool IsSliding() const { return bIsSliding; }
+		bool IsWallRunning() const { return bIsWallRunning; }
+		int GetJumpCount() const { return JumpCount; }
+		float GetWallRunCooldown() const { return WallRunCooldown; }
+
+		/** Performs a pre-generated parkour link, called by UTP_ParkourPathFollowingComponent; wall-runs along the way are picked up by Tick as usual */
+		void TraverseParkourLink(const FTP_ParkourLink& Link);
+
+		/** Copies all dynamic movement state (including the wall-run cooldown) for a checkpoint */
+		void SaveCheckpointState(FTP_CharacterCheckpoint& OutCheckpoint) const;
+
+		/** Writes a checkpoint back in place, no respawn */
+		void RestoreCheckpointState(const FTP_CharacterCheckpoint& Checkpoint);
 
 
 	private:
@@ -130,6 +170,14 @@
 		void StopWallRun();
 		bool CanWallRun(FVector& OutWallNormal);
 		void ResetWallRun(); // Function to reset the cooldown
+
+		FTimerHandle ParkourDoubleJumpTimer;
+		void ParkourDoubleJump();
+
+		/** Set by TraverseParkourLink for links that jump off a wall-run, the jump is timed from when the wall-run starts */
+		bool bParkourWallJumpPending = false;
+		FTimerHandle ParkourWallJumpTimer;
+		void ParkourWallJump();
 	
 
 	
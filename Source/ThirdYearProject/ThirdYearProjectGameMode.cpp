@@ -2,8 +2,14 @@
 
 #include "ThirdYearProjectGameMode.h"
 #include "ThirdYearProjectCharacter.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LocalPlayer.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
 #include "UObject/ConstructorHelpers.h"
 
+DEFINE_LOG_CATEGORY(LogTPGameMode);
+
 AThirdYearProjectGameMode::AThirdYearProjectGameMode()
 	: Super()
 {
@@ -12,3 +18,60 @@ AThirdYearProjectGameMode::AThirdYearProjectGameMode()
 	DefaultPawnClass = PlayerPawnClassFinder.Class;
 
 }
+
+void AThirdYearProjectGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	NumLocalPlayers = UGameplayStatics::GetIntOption(Options, TEXT("Players"), NumLocalPlayers);
+}
+
+void AThirdYearProjectGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetNumLocalPlayers(NumLocalPlayers);
+}
+
+void AThirdYearProjectGameMode::SetNumLocalPlayers(int32 Count)
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	if (GameInstance == nullptr || GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	Count = FMath::Clamp(Count, 1, MaxLocalPlayers);
+
+	// New players get the next free controller id, so gamepads 1-3 drive players 2-4
+	while (GameInstance->GetNumLocalPlayers() < Count)
+	{
+		if (UGameplayStatics::CreatePlayer(this, -1, true) == nullptr)
+		{
+			UE_LOG(LogTPGameMode, Warning, TEXT("Could not create local player %d"), GameInstance->GetNumLocalPlayers() + 1);
+			break;
+		}
+	}
+
+	while (GameInstance->GetNumLocalPlayers() > Count)
+	{
+		const ULocalPlayer* LocalPlayer = GameInstance->GetLocalPlayerByIndex(GameInstance->GetNumLocalPlayers() - 1);
+		APlayerController* PlayerController = LocalPlayer->GetPlayerController(GetWorld());
+		if (PlayerController == nullptr)
+		{
+			break;
+		}
+		UGameplayStatics::RemovePlayer(PlayerController, true);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTPSplitScreenPlayersCommand(
+	TEXT("TP.SplitScreen.Players"),
+	TEXT("Sets the number of local split-screen players. Usage: TP.SplitScreen.Players <1-4>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (AThirdYearProjectGameMode* GameMode = World->GetAuthGameMode<AThirdYearProjectGameMode>())
+		{
+			GameMode->SetNumLocalPlayers(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1);
+		}
+	}));
@@ -6,13 +6,30 @@
 #include "GameFramework/GameModeBase.h"
 #include "ThirdYearProjectGameMode.generated.h"
 
-UCLASS(minimalapi)
+DECLARE_LOG_CATEGORY_EXTERN(LogTPGameMode, Log, All);
+
+UCLASS(minimalapi, config=Game)
 class AThirdYearProjectGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	AThirdYearProjectGameMode();
+
+	/** Split-screen supports up to four local players */
+	static constexpr int32 MaxLocalPlayers = 4;
+
+	/** Local players created when play starts, ?Players=N on the map URL overrides it */
+	UPROPERTY(config, EditAnywhere, Category=SplitScreen, meta=(ClampMin=1, ClampMax=4))
+	int32 NumLocalPlayers = 1;
+
+	/** Adds or removes local split-screen players until there are Count of them */
+	void SetNumLocalPlayers(int32 Count);
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+protected:
+	virtual void BeginPlay() override;
 };
 
 
@@ -2,8 +2,11 @@
 
 #include "ThirdYearProjectProjectile.h"
 #include "GameFramework/ProjectileMovementComponent.h"
-#include "GameFramework/Character.h"
 #include "Components/SphereComponent.h"
+#include "TP_CheckpointSubsystem.h"
+#include "TP_ExplosionSubsystem.h"
+#include "TP_ReplaySubsystem.h"
+#include "TP_FrameBudgetSubsystem.h"
 
 AThirdYearProjectProjectile::AThirdYearProjectProjectile() 
 {
@@ -32,51 +35,85 @@ AThirdYearProjectProjectile::AThirdYearProjectProjectile()
 	InitialLifeSpan = 3.0f;
 }
 
+void AThirdYearProjectProjectile::BeginPlay()
+{
+    Super::BeginPlay();
+
+    if (UTP_ReplaySubsystem* Replay = GetWorld()->GetSubsystem<UTP_ReplaySubsystem>())
+    {
+        Replay->RegisterProjectile(this);
+    }
+
+    // Counts against the live projectile cap, the oldest ones retire early under load
+    if (UTP_FrameBudgetSubsystem* FrameBudget = GetWorld()->GetSubsystem<UTP_FrameBudgetSubsystem>())
+    {
+        FrameBudget->TrackProjectile(this);
+    }
+}
+
 void AThirdYearProjectProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
-    FVector ExplosionOrigin = GetActorLocation();
-    float ExplosionRadius = 500.0f;  // Radius of the effect
-    float ExplosionForce = 2000.0f;  // Strength of the force applied
+    if (bParked)
+    {
+        return;
+    }
 
-    // Find all actors in the explosion radius
-    TArray<FOverlapResult> OverlapResults;
-    FCollisionShape CollisionSphere = FCollisionShape::MakeSphere(ExplosionRadius);
+    Explode(GetWorld(), GetActorLocation(), this);
 
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActor(this); // Ignore the projectile itself
+    // Destroy the projectile after applying effects
+    Retire();
+}
 
-    GetWorld()->OverlapMultiByChannel(OverlapResults, ExplosionOrigin, FQuat::Identity, ECC_PhysicsBody, CollisionSphere, QueryParams);
+void AThirdYearProjectProjectile::LifeSpanExpired()
+{
+    Retire();
+}
 
-    for (const FOverlapResult& Result : OverlapResults)
+void AThirdYearProjectProjectile::Retire()
+{
+    UTP_CheckpointSubsystem* CheckpointSubsystem = GetWorld()->GetSubsystem<UTP_CheckpointSubsystem>();
+    if (CheckpointSubsystem && CheckpointSubsystem->ShouldParkProjectile(this))
+    {
+        SetParked(true);
+    }
+    else
     {
-        AActor* AffectedActor = Result.GetActor();
-        if (AffectedActor && AffectedActor != this)
-        {
-            UPrimitiveComponent* AffectedComponent = Cast<UPrimitiveComponent>(Result.GetComponent());
-            if (AffectedComponent)
-            {
-                FVector Direction = AffectedComponent->GetComponentLocation() - ExplosionOrigin;
-                float Distance = Direction.Size();
-                Direction.Normalize();
-
-                float ScaledForce = ExplosionForce * (1.0f - (Distance / ExplosionRadius)); // Scale force based on distance
-
-                // Apply force to physics objects
-                if (AffectedComponent->IsSimulatingPhysics())
-                {
-                    AffectedComponent->AddImpulse(Direction * ScaledForce, NAME_None, true);
-                }
-
-                // Apply force to characters
-                ACharacter* AffectedCharacter = Cast<ACharacter>(AffectedActor);
-                if (AffectedCharacter)
-                {
-                    AffectedCharacter->LaunchCharacter(Direction * ScaledForce, true, true);
-                }
-            }
-        }
+        Destroy();
     }
+}
 
-    // Destroy the projectile after applying effects
-    Destroy();
+void AThirdYearProjectProjectile::SetParked(bool bNewParked)
+{
+    bParked = bNewParked;
+    SetActorHiddenInGame(bParked);
+    SetActorEnableCollision(!bParked);
+    ProjectileMovement->SetComponentTickEnabled(!bParked);
+
+    if (bParked)
+    {
+        ProjectileMovement->StopMovementImmediately();
+        SetLifeSpan(0.f);
+    }
+}
+
+void AThirdYearProjectProjectile::RestoreFlight(const FVector& Location, const FRotator& Rotation, const FVector& Velocity, float LifeSpanRemaining)
+{
+    SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+    SetParked(false);
+
+    if (ProjectileMovement->UpdatedComponent == nullptr)
+    {
+        ProjectileMovement->SetUpdatedComponent(CollisionComp);
+    }
+    ProjectileMovement->Velocity = Velocity;
+    SetLifeSpan(FMath::Max(LifeSpanRemaining, UE_KINDA_SMALL_NUMBER));
+}
+
+void AThirdYearProjectProjectile::Explode(UWorld* World, const FVector& ExplosionOrigin, const AActor* IgnoredActor, float ForceScale)
+{
+    // Range, falloff and line of sight are resolved by the explosion subsystem
+    if (UTP_ExplosionSubsystem* ExplosionSubsystem = World->GetSubsystem<UTP_ExplosionSubsystem>())
+    {
+        ExplosionSubsystem->Explode(ExplosionOrigin, IgnoredActor, ForceScale);
+    }
 }
\ No newline at end of file
@@ -29,9 +29,32 @@ public:
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	/**
+	 * Pushes simulated bodies and launches characters around Origin, scaled by distance and cover (see UTP_ExplosionSubsystem).
+	 * ForceScale only multiplies the push on simulated bodies
+	 */
+	static void Explode(UWorld* World, const FVector& Origin, const AActor* IgnoredActor, float ForceScale = 1.f);
+
+	/** Parked projectiles are hidden and inert, kept alive so a checkpoint can bring them back */
+	void SetParked(bool bNewParked);
+	bool IsParked() const { return bParked; }
+
+	/** Puts the projectile back in flight with the given state */
+	void RestoreFlight(const FVector& Location, const FRotator& Rotation, const FVector& Velocity, float LifeSpanRemaining);
+
 	/** Returns CollisionComp subobject **/
 	USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
 	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void LifeSpanExpired() override;
+
+private:
+	/** Destroys the projectile, or parks it when a checkpoint still needs it */
+	void Retire();
+
+	bool bParked = false;
 };
 
@@ -11,5 +11,6 @@ public class ThirdYearProjectEditorTarget : TargetRules
 		DefaultBuildSettings = BuildSettingsVersion.V4;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_3;
 		ExtraModuleNames.Add("ThirdYearProject");
+		ExtraModuleNames.Add("ThirdYearProjectEditor");
 	}
 }
@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_HLODReportBuilder.h"
+#include "TP_HLODSetupBuilder.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "UObject/UnrealType.h"
+#include "WorldPartition/HLOD/HLODActor.h"
+#include "WorldPartition/WorldPartition.h"
+#include "WorldPartition/WorldPartitionRuntimeSpatialHash.h"
+
+namespace TPHLODReport
+{
+	/** Engine default for the main runtime grid, only used when the map's own settings can't be read */
+	static constexpr float DefaultCellSize = 25600.f;
+
+	/** One row: a cell of one runtime grid, either its source actors (HLODLevel INDEX_NONE) or one HLOD level */
+	struct FCellKey
+	{
+		FName Grid;
+		int32 HLODLevel = INDEX_NONE;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+
+		bool operator==(const FCellKey& Other) const
+		{
+			return Grid == Other.Grid && HLODLevel == Other.HLODLevel && Cell == Other.Cell;
+		}
+
+		friend uint32 GetTypeHash(const FCellKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Grid), GetTypeHash(Key.HLODLevel)), GetTypeHash(Key.Cell));
+		}
+	};
+
+	struct FCellCost
+	{
+		int32 Actors = 0;
+		int32 Components = 0;
+		int32 Primitives = 0;
+		int64 Bytes = 0;
+
+		/** Meshes already counted in this cell */
+		TSet<UStaticMesh*> Meshes;
+
+		void Add(AActor* Actor)
+		{
+			++Actors;
+			Bytes += Actor->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+
+			for (UActorComponent* Component : Actor->GetComponents())
+			{
+				if (Component == nullptr)
+				{
+					continue;
+				}
+
+				++Components;
+				Bytes += Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+
+				if (Component->IsA<UPrimitiveComponent>())
+				{
+					++Primitives;
+				}
+
+				const UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(Component);
+				UStaticMesh* Mesh = MeshComponent ? MeshComponent->GetStaticMesh() : nullptr;
+				if (Mesh != nullptr && !Meshes.Contains(Mesh))
+				{
+					Meshes.Add(Mesh);
+					Bytes += Mesh->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+				}
+			}
+		}
+
+		void Append(const FCellCost& Other)
+		{
+			Actors += Other.Actors;
+			Components += Other.Components;
+			Primitives += Other.Primitives;
+			Bytes += Other.Bytes;
+		}
+	};
+
+	static double ToMB(int64 Bytes)
+	{
+		return Bytes / (1024.0 * 1024.0);
+	}
+
+	/** Cell size of every runtime grid in the map's spatial hash settings, the first one is the main grid */
+	static void GetGridCellSizes(const UWorld* World, TArray<TPair<FName, float>>& OutGrids)
+	{
+		const UWorldPartition* WorldPartition = World->GetWorldPartition();
+		const UWorldPartitionRuntimeSpatialHash* SpatialHash = WorldPartition ? Cast<UWorldPartitionRuntimeSpatialHash>(WorldPartition->RuntimeHash) : nullptr;
+		if (SpatialHash == nullptr)
+		{
+			return;
+		}
+
+		// The hash doesn't expose its grid settings, they are an editor property
+		const FArrayProperty* GridsProperty = FindFProperty<FArrayProperty>(UWorldPartitionRuntimeSpatialHash::StaticClass(), TEXT("Grids"));
+		const FStructProperty* GridProperty = GridsProperty ? CastField<FStructProperty>(GridsProperty->Inner) : nullptr;
+		if (GridProperty == nullptr || GridProperty->Struct != FSpatialHashRuntimeGrid::StaticStruct())
+		{
+			return;
+		}
+
+		FScriptArrayHelper Grids(GridsProperty, GridsProperty->ContainerPtrToValuePtr<void>(SpatialHash));
+		for (int32 Index = 0; Index < Grids.Num(); ++Index)
+		{
+			const FSpatialHashRuntimeGrid& Grid = *reinterpret_cast<const FSpatialHashRuntimeGrid*>(Grids.GetRawPtr(Index));
+			OutGrids.Emplace(Grid.GridName, static_cast<float>(Grid.CellSize));
+		}
+	}
+
+	/** HLOD layers name their runtime grid HLOD<Level>_<CellSize>m_<LoadingRange>m, 0 if Grid isn't one of those */
+	static float GetHLODGridCellSize(FName Grid)
+	{
+		TArray<FString> Parts;
+		Grid.ToString().ParseIntoArray(Parts, TEXT("_"));
+		return Parts.Num() >= 2 && Parts[0].StartsWith(TEXT("HLOD")) && Parts[1].EndsWith(TEXT("m")) ? FCString::Atof(*Parts[1].LeftChop(1)) * 100.f : 0.f;
+	}
+}
+
+UTP_HLODReportBuilder::UTP_HLODReportBuilder(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, CellSize(TPHLODReport::DefaultCellSize)
+{
+	FParse::Value(FCommandLine::Get(), TEXT("CellSize="), CellSize);
+	CellSize = FMath::Max(CellSize, 100.f);
+
+	if (!FParse::Value(FCommandLine::Get(), TEXT("Label="), Label))
+	{
+		Label = FDateTime::Now().ToString();
+	}
+}
+
+bool UTP_HLODReportBuilder::RunInternal(UWorld* World, const FCellInfo& InCellInfo, FPackageSourceControlHelper& PackageHelper)
+{
+	using namespace TPHLODReport;
+
+	// Cell sizes from the map itself; -CellSize (or the engine default) only stands in for grids it doesn't describe
+	TArray<TPair<FName, float>> Grids;
+	GetGridCellSizes(World, Grids);
+	const FName MainGrid = Grids.Num() > 0 ? Grids[0].Key : FName(TEXT("MainGrid"));
+	auto GetCellSize = [&Grids, this](FName Grid)
+	{
+		for (const TPair<FName, float>& Pair : Grids)
+		{
+			if (Pair.Key == Grid)
+			{
+				return FMath::Max(Pair.Value, 100.f);
+			}
+		}
+		const float HLODCellSize = GetHLODGridCellSize(Grid);
+		return HLODCellSize > 0.f ? HLODCellSize : CellSize;
+	};
+
+	TMap<FCellKey, FCellCost> Cells;
+	FCellCost AlwaysLoaded;
+
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		AActor* Actor = *It;
+		if (Actor->IsEditorOnly() || Actor->IsTemplate())
+		{
+			continue;
+		}
+
+		const AWorldPartitionHLOD* HLODActor = Cast<AWorldPartitionHLOD>(Actor);
+		if (HLODActor == nullptr && !Actor->GetIsSpatiallyLoaded())
+		{
+			// Streams with the map, HLODs change nothing for these
+			AlwaysLoaded.Add(Actor);
+			continue;
+		}
+
+		// Every actor goes in a cell of its own grid; HLOD actors carry their layer's grid and level
+		FCellKey Key;
+		Key.Grid = Actor->GetRuntimeGrid().IsNone() ? MainGrid : Actor->GetRuntimeGrid();
+		Key.HLODLevel = HLODActor ? static_cast<int32>(HLODActor->GetLODLevel()) : INDEX_NONE;
+
+		const float GridCellSize = GetCellSize(Key.Grid);
+		const FBox Bounds = Actor->GetStreamingBounds();
+		const FVector Centre = Bounds.IsValid ? Bounds.GetCenter() : Actor->GetActorLocation();
+		Key.Cell = FIntPoint(FMath::FloorToInt32(Centre.X / GridCellSize), FMath::FloorToInt32(Centre.Y / GridCellSize));
+
+		Cells.FindOrAdd(Key).Add(Actor);
+	}
+
+	Cells.KeySort([](const FCellKey& A, const FCellKey& B)
+	{
+		if (A.Grid != B.Grid)
+		{
+			return A.Grid.LexicalLess(B.Grid);
+		}
+		if (A.HLODLevel != B.HLODLevel)
+		{
+			return A.HLODLevel < B.HLODLevel;
+		}
+		return A.Cell.Y != B.Cell.Y ? A.Cell.Y < B.Cell.Y : A.Cell.X < B.Cell.X;
+	});
+
+	TArray<FString> Lines;
+	Lines.Add(TEXT("Grid,HLODLevel,CellSize,CellX,CellY,Actors,Components,Primitives,Bytes"));
+
+	UE_LOG(LogTPHLOD, Display, TEXT("%s: grid level cell size (x, y): actors / components / primitives / MB, level -1 is source actors"), *World->GetName());
+
+	FCellCost SourceTotal;
+	FCellCost HLODTotal;
+	for (const TPair<FCellKey, FCellCost>& Pair : Cells)
+	{
+		const FCellKey& Key = Pair.Key;
+		const FCellCost& Cost = Pair.Value;
+		const float GridCellSize = GetCellSize(Key.Grid);
+
+		UE_LOG(LogTPHLOD, Display, TEXT("  %s %2d %.0f (%3d, %3d): %5d / %6d / %6d / %8.2f"),
+			*Key.Grid.ToString(), Key.HLODLevel, GridCellSize, Key.Cell.X, Key.Cell.Y,
+			Cost.Actors, Cost.Components, Cost.Primitives, ToMB(Cost.Bytes));
+
+		Lines.Add(FString::Printf(TEXT("%s,%d,%.0f,%d,%d,%d,%d,%d,%lld"),
+			*Key.Grid.ToString(), Key.HLODLevel, GridCellSize, Key.Cell.X, Key.Cell.Y,
+			Cost.Actors, Cost.Components, Cost.Primitives, Cost.Bytes));
+
+		(Key.HLODLevel == INDEX_NONE ? SourceTotal : HLODTotal).Append(Cost);
+	}
+
+	UE_LOG(LogTPHLOD, Display, TEXT("  %d cells, source %5d / %6d / %6d / %8.2f -> HLOD %4d / %5d / %5d / %8.2f"),
+		Cells.Num(),
+		SourceTotal.Actors, SourceTotal.Components, SourceTotal.Primitives, ToMB(SourceTotal.Bytes),
+		HLODTotal.Actors, HLODTotal.Components, HLODTotal.Primitives, ToMB(HLODTotal.Bytes));
+	UE_LOG(LogTPHLOD, Display, TEXT("  always loaded %d actors / %d components / %.2f MB"), AlwaysLoaded.Actors, AlwaysLoaded.Components, ToMB(AlwaysLoaded.Bytes));
+
+	if (HLODTotal.Actors == 0)
+	{
+		UE_LOG(LogTPHLOD, Display, TEXT("No HLOD actors yet, run TP_HLODSetupBuilder and WorldPartitionHLODsBuilder"));
+	}
+
+	const FString ReportPath = FPaths::ProjectSavedDir() / TEXT("HLOD") / FString::Printf(TEXT("%s-%s.csv"), *World->GetName(), *Label);
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *ReportPath))
+	{
+		UE_LOG(LogTPHLOD, Error, TEXT("Couldn't write %s"), *ReportPath);
+		return false;
+	}
+
+	UE_LOG(LogTPHLOD, Display, TEXT("Wrote %s"), *FPaths::ConvertRelativePathToFull(ReportPath));
+	return true;
+}
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldPartition/WorldPartitionBuilder.h"
+#include "TP_HLODReportBuilder.generated.h"
+
+/**
+ * Reports what each streaming cell costs with and without HLODs: actors, components, primitive components and
+ * estimated memory (components plus every static mesh they use, each mesh counted once per cell), split into the
+ * source actors streamed in up close and the HLOD actors shown in their place from afar.
+ *
+ * Every actor goes in a cell of its own runtime grid, by its bounds centre, and HLOD actors are kept apart per HLOD level,
+ * so a row is one (grid, level, cell). Cell sizes come from the map's runtime spatial hash settings and the HLOD layers'
+ * grid names; -CellSize only stands in for a grid neither describes. The table is logged and written to
+ * Saved/HLOD/<Map>-<Label>.csv, run it before and after building HLODs to compare.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd ThirdYearProject.uproject /Game/FirstPerson/Maps/FirstPersonMap -run=WorldPartitionBuilderCommandlet
+ *     -Builder=TP_HLODReportBuilder [-CellSize=25600] [-Label=after] -nullrhi -unattended
+ */
+UCLASS()
+class UTP_HLODReportBuilder : public UWorldPartitionBuilder
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	// UWorldPartitionBuilder interface begin
+	virtual bool RequiresCommandletRendering() const override { return false; }
+	virtual ELoadingMode GetLoadingMode() const override { return ELoadingMode::EntireWorld; }
+
+protected:
+	virtual bool RunInternal(UWorld* World, const FCellInfo& InCellInfo, FPackageSourceControlHelper& PackageHelper) override;
+	// UWorldPartitionBuilder interface end
+
+private:
+	/** For grids the map doesn't describe */
+	float CellSize;
+	FString Label;
+};
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_HLODSetupBuilder.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "PackageSourceControlHelper.h"
+#include "WorldPartition/HLOD/HLODLayer.h"
+#include "WorldPartition/WorldPartition.h"
+
+DEFINE_LOG_CATEGORY(LogTPHLOD);
+
+UTP_HLODSetupBuilder::UTP_HLODSetupBuilder(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, bForce(FParse::Param(FCommandLine::Get(), TEXT("Force")))
+	, bInstancedOnly(!FApp::CanEverRender() || !FParse::Param(FCommandLine::Get(), TEXT("AllowCommandletRendering")))
+{
+}
+
+bool UTP_HLODSetupBuilder::RunInternal(UWorld* World, const FCellInfo& InCellInfo, FPackageSourceControlHelper& PackageHelper)
+{
+	UWorldPartition* WorldPartition = World->GetWorldPartition();
+	if (WorldPartition == nullptr)
+	{
+		UE_LOG(LogTPHLOD, Error, TEXT("%s is not a World Partition map"), *World->GetName());
+		return false;
+	}
+
+	if (WorldPartition->DefaultHLODLayer != nullptr && !bForce)
+	{
+		UE_LOG(LogTPHLOD, Display, TEXT("%s already uses HLOD layer %s, nothing to do (-Force to replace it)"), *World->GetName(), *WorldPartition->DefaultHLODLayer->GetName());
+		return true;
+	}
+
+	// Layers live next to the map: /Game/FirstPerson/Maps/HLOD/FirstPersonMap_...
+	const FString LayerPath = FPackageName::GetLongPackagePath(World->GetPackage()->GetName()) / TEXT("HLOD");
+	UHLODLayer* DefaultLayer = UHLODLayer::DuplicateHLODLayersSetup(UHLODLayer::GetEngineDefaultHLODLayersSetup(), LayerPath, World->GetName());
+	if (DefaultLayer == nullptr)
+	{
+		UE_LOG(LogTPHLOD, Error, TEXT("No engine default HLOD layer setup to start from"));
+		return false;
+	}
+
+	TArray<UPackage*> Packages;
+	for (UHLODLayer* Layer = DefaultLayer; Layer != nullptr; Layer = Layer->GetParentLayer().LoadSynchronous())
+	{
+		if (bInstancedOnly && Layer->GetLayerType() != EHLODLayerType::Instancing)
+		{
+			UE_LOG(LogTPHLOD, Display, TEXT("%s switched to instancing, merging needs rendering (no -nullrhi) and -AllowCommandletRendering"), *Layer->GetName());
+			Layer->SetLayerType(EHLODLayerType::Instancing);
+		}
+
+		UE_LOG(LogTPHLOD, Display, TEXT("HLOD layer %s (%s)"), *Layer->GetPathName(), *UEnum::GetValueAsString(Layer->GetLayerType()));
+		Packages.AddUnique(Layer->GetPackage());
+	}
+
+	WorldPartition->Modify();
+	WorldPartition->DefaultHLODLayer = DefaultLayer;
+	Packages.Add(World->GetPackage());
+
+	return SavePackages(Packages, PackageHelper);
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldPartition/WorldPartitionBuilder.h"
+#include "TP_HLODSetupBuilder.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPHLOD, Log, All);
+
+/**
+ * Gives a World Partition map its HLOD layers, once: duplicates the engine's default HLOD layer setup next to the map
+ * and makes it the map's default layer, so every spatially loaded actor gets an HLOD proxy.
+ *
+ * Without rendering (-nullrhi, Linux build boxes) merged layers can't bake their materials, so every layer is switched
+ * to instancing; run without -nullrhi and with -AllowCommandletRendering on a machine with a GPU to keep the engine's
+ * merged layers (Scripts/BuildHLODs.sh does this with HLOD_RENDERING=1).
+ * Maps that already have a default HLOD layer are left alone unless -Force is given.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd ThirdYearProject.uproject /Game/FirstPerson/Maps/FirstPersonMap -run=WorldPartitionBuilderCommandlet
+ *     -Builder=TP_HLODSetupBuilder [-Force] -nullrhi -unattended
+ * then build the proxies with the engine's WorldPartitionHLODsBuilder, see Scripts/BuildHLODs.sh.
+ */
+UCLASS()
+class UTP_HLODSetupBuilder : public UWorldPartitionBuilder
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	// UWorldPartitionBuilder interface begin
+	virtual bool RequiresCommandletRendering() const override { return false; }
+	virtual ELoadingMode GetLoadingMode() const override { return ELoadingMode::Custom; }
+
+protected:
+	virtual bool RunInternal(UWorld* World, const FCellInfo& InCellInfo, FPackageSourceControlHelper& PackageHelper) override;
+	// UWorldPartitionBuilder interface end
+
+private:
+	/** Replace an existing default HLOD layer */
+	bool bForce;
+
+	/** Switch every layer to instancing, on when the commandlet can't render */
+	bool bInstancedOnly;
+};
@@ -0,0 +1,351 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_ParkourNavLinkBuilder.h"
+#include "TP_ParkourNavLinkActor.h"
+#include "TP_ParkourMovementModel.h"
+#include "Async/ParallelFor.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/Parse.h"
+#include "PackageSourceControlHelper.h"
+
+DEFINE_LOG_CATEGORY(LogTPParkourNavLinks);
+
+namespace TPParkourNavLinks
+{
+	// Matches the capsule set up in AThirdYearProjectCharacter's constructor
+	static constexpr float CapsuleRadius = 55.f;
+	static constexpr float CapsuleHalfHeight = 96.f;
+	static constexpr float MaxStepHeight = 45.f;
+	static constexpr float WalkableFloorZ = 0.71f;
+	static constexpr float SimulationStep = 1.f / 30.f;
+	static constexpr float WallRunCooldown = 0.3f;
+
+	struct FFloorSample
+	{
+		FVector Location = FVector::ZeroVector;
+		bool bWalkable = false;
+	};
+
+	struct FLedge
+	{
+		FVector Location;
+		FVector Outward;
+	};
+
+	struct FLaunchOption
+	{
+		FVector Velocity;
+		uint8 Moves;
+		bool bDoubleJumpAtApex;
+	};
+
+	struct FSimulationResult
+	{
+		FVector Landing = FVector::ZeroVector;
+		float FlightTime = 0.f;
+		uint8 Moves = 0;
+		bool bLanded = false;
+	};
+
+	/** Replays the character's airborne rules (auto wall-run, wall jump, double jump) with capsule sweeps */
+	static FSimulationResult SimulateMove(const UWorld* World, const FVector& Start, const FVector& Forward, const FLaunchOption& Option, float MaxFlightTime)
+	{
+		const FCollisionShape Capsule = FCollisionShape::MakeCapsule(CapsuleRadius, CapsuleHalfHeight);
+		const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TPParkourNavLinkSim), false);
+		const float GravityZ = World->GetGravityZ();
+		const FVector Right = FVector::CrossProduct(FVector::UpVector, Forward);
+
+		FSimulationResult Result;
+		Result.Moves = Option.Moves;
+
+		FVector Location = Start;
+		FVector Velocity = Option.Velocity;
+		float GravityScale = 1.f;
+		int32 JumpCount = 1;
+		bool bWallRunning = false;
+		float WallRunTime = 0.f;
+		float WallRunCooldownLeft = 0.f;
+		FVector WallNormal = FVector::ZeroVector;
+
+		for (float Time = 0.f; Time < MaxFlightTime; Time += SimulationStep)
+		{
+			FHitResult Hit;
+
+			if (bWallRunning)
+			{
+				WallRunTime += SimulationStep;
+				const bool bWallLost = !World->LineTraceSingleByChannel(Hit, Location, Location - WallNormal * FTP_ParkourMovementModel::WallProbeDistance, ECC_Visibility, QueryParams);
+				if (bWallLost || WallRunTime >= FTP_ParkourMovementModel::LinkWallRunHoldTime)
+				{
+					bWallRunning = false;
+					GravityScale = 1.f;
+					WallRunCooldownLeft = WallRunCooldown;
+					if (!bWallLost && JumpCount < FTP_ParkourMovementModel::MaxJumps)
+					{
+						Velocity = FTP_ParkourMovementModel::GetWallJumpVelocity(WallNormal, Forward);
+						Result.Moves |= static_cast<uint8>(ETP_ParkourMove::WallJump);
+						++JumpCount;
+					}
+				}
+			}
+			else if (WallRunCooldownLeft <= 0.f)
+			{
+				// Same probes as AThirdYearProjectCharacter::CanWallRun, right side first
+				const bool bWallFound =
+					World->LineTraceSingleByChannel(Hit, Location, Location + Right * FTP_ParkourMovementModel::WallProbeDistance, ECC_Visibility, QueryParams) ||
+					World->LineTraceSingleByChannel(Hit, Location, Location - Right * FTP_ParkourMovementModel::WallProbeDistance, ECC_Visibility, QueryParams);
+				if (bWallFound)
+				{
+					bWallRunning = true;
+					WallRunTime = 0.f;
+					WallNormal = Hit.Normal;
+					GravityScale = FTP_ParkourMovementModel::WallRunGravityScale;
+					JumpCount = 0;
+					Velocity = FTP_ParkourMovementModel::GetWallRunDirection(WallNormal, Forward) * FTP_ParkourMovementModel::WallRunSpeed;
+					Result.Moves |= static_cast<uint8>(ETP_ParkourMove::WallRun);
+				}
+			}
+			else
+			{
+				WallRunCooldownLeft -= SimulationStep;
+			}
+
+			if (Option.bDoubleJumpAtApex && !bWallRunning && JumpCount < FTP_ParkourMovementModel::MaxJumps && Velocity.Z <= 0.f)
+			{
+				Velocity = FTP_ParkourMovementModel::ApplyLaunch(Velocity, FTP_ParkourMovementModel::GetDoubleJumpVelocity(Velocity, FTP_ParkourMovementModel::JumpZVelocity), false, true);
+				Result.Moves |= static_cast<uint8>(ETP_ParkourMove::DoubleJump);
+				++JumpCount;
+			}
+
+			Velocity.Z += GravityZ * GravityScale * SimulationStep;
+			const FVector End = Location + Velocity * SimulationStep;
+
+			if (World->SweepSingleByChannel(Hit, Location, End, FQuat::Identity, ECC_Pawn, Capsule, QueryParams))
+			{
+				if (Hit.bStartPenetrating)
+				{
+					return Result;
+				}
+
+				if (Hit.ImpactNormal.Z >= WalkableFloorZ)
+				{
+					Result.bLanded = true;
+					Result.Landing = Hit.Location - FVector(0.f, 0.f, CapsuleHalfHeight);
+					Result.FlightTime = Time + SimulationStep * Hit.Time;
+					return Result;
+				}
+
+				// Slide along walls and ceilings like the movement component does
+				Location = Hit.Location;
+				Velocity = FVector::VectorPlaneProject(Velocity, Hit.ImpactNormal);
+				continue;
+			}
+
+			Location = End;
+		}
+
+		return Result;
+	}
+}
+
+UTP_ParkourNavLinkBuilder::UTP_ParkourNavLinkBuilder(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, SampleSpacing(100.f)
+	, MaxFlightTime(3.f)
+{
+	FParse::Value(FCommandLine::Get(), TEXT("SampleSpacing="), SampleSpacing);
+	FParse::Value(FCommandLine::Get(), TEXT("MaxFlightTime="), MaxFlightTime);
+	SampleSpacing = FMath::Max(SampleSpacing, 25.f);
+}
+
+bool UTP_ParkourNavLinkBuilder::RunInternal(UWorld* World, const FCellInfo& InCellInfo, FPackageSourceControlHelper& PackageHelper)
+{
+	using namespace TPParkourNavLinks;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Bounds of everything the character could stand on
+	FBox WorldBounds(ForceInit);
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		if (It->IsA<ATP_ParkourNavLinkActor>())
+		{
+			continue;
+		}
+
+		It->ForEachComponent<UPrimitiveComponent>(false, [&WorldBounds](const UPrimitiveComponent* Primitive)
+		{
+			if (Primitive->IsRegistered() && Primitive->GetCollisionResponseToChannel(ECC_Pawn) == ECR_Block)
+			{
+				WorldBounds += Primitive->Bounds.GetBox();
+			}
+		});
+	}
+
+	if (!WorldBounds.IsValid)
+	{
+		UE_LOG(LogTPParkourNavLinks, Warning, TEXT("No collision found in %s, nothing to generate."), *World->GetName());
+		return true;
+	}
+
+	const int32 NumX = FMath::CeilToInt32(WorldBounds.GetSize().X / SampleSpacing);
+	const int32 NumY = FMath::CeilToInt32(WorldBounds.GetSize().Y / SampleSpacing);
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TPParkourNavLinkFloor), false);
+
+	// 1. Floor samples, one downward trace per grid cell
+	TArray<FFloorSample> Floor;
+	Floor.SetNum(NumX * NumY);
+	ParallelFor(Floor.Num(), [&](int32 Index)
+	{
+		const FVector Column(WorldBounds.Min.X + (Index % NumX + 0.5f) * SampleSpacing, WorldBounds.Min.Y + (Index / NumX + 0.5f) * SampleSpacing, 0.f);
+
+		FHitResult Hit;
+		if (World->LineTraceSingleByChannel(Hit, FVector(Column.X, Column.Y, WorldBounds.Max.Z + 10.f), FVector(Column.X, Column.Y, WorldBounds.Min.Z - 10.f), ECC_Visibility, QueryParams))
+		{
+			Floor[Index].Location = Hit.ImpactPoint;
+			Floor[Index].bWalkable = Hit.ImpactNormal.Z >= WalkableFloorZ;
+		}
+	});
+
+	// 2. Ledges: walkable samples next to a drop, a gap or a step the character can't walk up
+	TArray<FLedge> Ledges;
+	for (int32 Y = 0; Y < NumY; ++Y)
+	{
+		for (int32 X = 0; X < NumX; ++X)
+		{
+			const FFloorSample& Sample = Floor[Y * NumX + X];
+			if (!Sample.bWalkable)
+			{
+				continue;
+			}
+
+			FVector Outward = FVector::ZeroVector;
+			for (int32 OffsetY = -1; OffsetY <= 1; ++OffsetY)
+			{
+				for (int32 OffsetX = -1; OffsetX <= 1; ++OffsetX)
+				{
+					const int32 NeighbourX = X + OffsetX;
+					const int32 NeighbourY = Y + OffsetY;
+					if ((OffsetX == 0 && OffsetY == 0) || NeighbourX < 0 || NeighbourY < 0 || NeighbourX >= NumX || NeighbourY >= NumY)
+					{
+						continue;
+					}
+
+					const FFloorSample& Neighbour = Floor[NeighbourY * NumX + NeighbourX];
+					if (!Neighbour.bWalkable || FMath::Abs(Neighbour.Location.Z - Sample.Location.Z) > MaxStepHeight)
+					{
+						Outward += FVector(OffsetX, OffsetY, 0.f);
+					}
+				}
+			}
+
+			if (!Outward.IsNearlyZero())
+			{
+				Ledges.Add({ Sample.Location, Outward.GetSafeNormal() });
+			}
+		}
+	}
+
+	// 3. Simulate every move from every ledge; each ledge writes only its own slot so no locking is needed
+	static const float DirectionOffsets[] = { -45.f, 0.f, 45.f };
+	const int32 NumOptionsPerLedge = UE_ARRAY_COUNT(DirectionOffsets) * 3;
+
+	TArray<FTP_ParkourLink> Candidates;
+	Candidates.SetNum(Ledges.Num() * NumOptionsPerLedge);
+	TArray<bool> CandidateValid;
+	CandidateValid.SetNumZeroed(Candidates.Num());
+
+	ParallelFor(Ledges.Num(), [&](int32 LedgeIndex)
+	{
+		const FLedge& Ledge = Ledges[LedgeIndex];
+		const FVector Start = Ledge.Location + FVector(0.f, 0.f, CapsuleHalfHeight + 2.f);
+
+		for (int32 DirectionIndex = 0; DirectionIndex < UE_ARRAY_COUNT(DirectionOffsets); ++DirectionIndex)
+		{
+			const FVector Forward = Ledge.Outward.RotateAngleAxis(DirectionOffsets[DirectionIndex], FVector::UpVector);
+			const FVector SprintJump = Forward * FTP_ParkourMovementModel::SprintSpeed + FVector(0.f, 0.f, FTP_ParkourMovementModel::JumpZVelocity);
+
+			const FLaunchOption Options[] =
+			{
+				{ SprintJump, static_cast<uint8>(ETP_ParkourMove::Jump), false },
+				{ SprintJump, static_cast<uint8>(ETP_ParkourMove::Jump), true },
+				{ FTP_ParkourMovementModel::GetSlideJumpVelocity(Forward), static_cast<uint8>(ETP_ParkourMove::SlideJump), false },
+			};
+
+			for (int32 OptionIndex = 0; OptionIndex < UE_ARRAY_COUNT(Options); ++OptionIndex)
+			{
+				const FSimulationResult Result = SimulateMove(World, Start, Forward, Options[OptionIndex], MaxFlightTime);
+
+				// Landings next to the ledge on the same level are walkable already
+				const bool bUseful = Result.bLanded
+					&& (FVector::Dist2D(Result.Landing, Ledge.Location) > SampleSpacing * 2.f || FMath::Abs(Result.Landing.Z - Ledge.Location.Z) > MaxStepHeight);
+				if (!bUseful)
+				{
+					continue;
+				}
+
+				const int32 SlotIndex = LedgeIndex * NumOptionsPerLedge + DirectionIndex * UE_ARRAY_COUNT(Options) + OptionIndex;
+				FTP_ParkourLink& Link = Candidates[SlotIndex];
+				Link.Start = FVector3f(Ledge.Location);
+				Link.End = FVector3f(Result.Landing);
+				Link.TakeOffVelocity = FVector3f(Options[OptionIndex].Velocity);
+				Link.Moves = Result.Moves;
+				Link.FlightTimeDeciseconds = static_cast<uint8>(FMath::Clamp(FMath::RoundToInt32(Result.FlightTime * 10.f), 0, 255));
+				CandidateValid[SlotIndex] = true;
+			}
+		}
+	});
+
+	// 4. Neighbouring ledges find the same routes, keep one link per start/end cell pair
+	TSet<TPair<FIntVector, FIntVector>> SeenRoutes;
+	TArray<FTP_ParkourLink> Links;
+	const float CellSize = SampleSpacing * 2.f;
+	for (int32 Index = 0; Index < Candidates.Num(); ++Index)
+	{
+		if (!CandidateValid[Index])
+		{
+			continue;
+		}
+
+		const FTP_ParkourLink& Link = Candidates[Index];
+		const FIntVector StartCell(FVector(Link.Start) / CellSize);
+		const FIntVector EndCell(FVector(Link.End) / CellSize);
+
+		bool bAlreadySeen = false;
+		SeenRoutes.Add(TPair<FIntVector, FIntVector>(StartCell, EndCell), &bAlreadySeen);
+		if (!bAlreadySeen)
+		{
+			Links.Add(Link);
+		}
+	}
+
+	// 5. Store everything in one actor saved with the map
+	ATP_ParkourNavLinkActor* LinkActor = nullptr;
+	for (TActorIterator<ATP_ParkourNavLinkActor> It(World); It; ++It)
+	{
+		LinkActor = *It;
+		break;
+	}
+
+	if (LinkActor == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Name = TEXT("ParkourNavLinks");
+		LinkActor = World->SpawnActor<ATP_ParkourNavLinkActor>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	}
+
+	const int32 NumLinks = Links.Num();
+	LinkActor->Modify();
+	LinkActor->SetLinks(MoveTemp(Links));
+
+	UPackage* LinkPackage = LinkActor->GetExternalPackage() ? LinkActor->GetExternalPackage() : LinkActor->GetPackage();
+	const bool bSaved = SavePackages({ LinkPackage }, PackageHelper);
+
+	UE_LOG(LogTPParkourNavLinks, Display, TEXT("%s: %d floor samples, %d ledges, %d parkour links (%d bytes) in %.1fs"),
+		*World->GetName(), Floor.Num(), Ledges.Num(), NumLinks, NumLinks * static_cast<int32>(sizeof(FTP_ParkourLink)), FPlatformTime::Seconds() - StartTime);
+
+	return bSaved;
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldPartition/WorldPartitionBuilder.h"
+#include "TP_ParkourNavLinkBuilder.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTPParkourNavLinks, Log, All);
+
+/**
+ * Headless builder that generates the parkour nav links for a World Partition map.
+ *
+ * Walkable ledges are sampled on a grid, then jumps, double jumps, slide jumps and wall-runs are simulated from every
+ * ledge in parallel using the same launch rules as AThirdYearProjectCharacter. Landings are stored in a single
+ * ATP_ParkourNavLinkActor saved with the map.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd ThirdYearProject.uproject /Game/FirstPerson/Maps/FirstPersonMap -run=WorldPartitionBuilderCommandlet
+ *     -Builder=TP_ParkourNavLinkBuilder [-SampleSpacing=100] [-MaxFlightTime=3] -AllowCommandletRendering=false -unattended
+ */
+UCLASS()
+class UTP_ParkourNavLinkBuilder : public UWorldPartitionBuilder
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	// UWorldPartitionBuilder interface begin
+	virtual bool RequiresCommandletRendering() const override { return false; }
+	virtual ELoadingMode GetLoadingMode() const override { return ELoadingMode::EntireWorld; }
+
+protected:
+	virtual bool RunInternal(UWorld* World, const FCellInfo& InCellInfo, FPackageSourceControlHelper& PackageHelper) override;
+	// UWorldPartitionBuilder interface end
+
+private:
+	/** Distance between floor samples */
+	float SampleSpacing;
+
+	/** Longest move that is simulated */
+	float MaxFlightTime;
+};
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TP_SimulationBenchmarkBuilder.h"
+#include "TP_ParkourSimulation.h"
+#include "Misc/Parse.h"
+
+UTP_SimulationBenchmarkBuilder::UTP_SimulationBenchmarkBuilder(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, NumEnvironments(256)
+	, NumCharacters(4)
+	, Seconds(60.f)
+{
+	FParse::Value(FCommandLine::Get(), TEXT("Environments="), NumEnvironments);
+	FParse::Value(FCommandLine::Get(), TEXT("Characters="), NumCharacters);
+	FParse::Value(FCommandLine::Get(), TEXT("Seconds="), Seconds);
+}
+
+bool UTP_SimulationBenchmarkBuilder::RunInternal(UWorld* World, const FCellInfo& InCellInfo, FPackageSourceControlHelper& PackageHelper)
+{
+	FTP_SimulationPool::RunBenchmark(World, NumEnvironments, NumCharacters, Seconds);
+	return true;
+}
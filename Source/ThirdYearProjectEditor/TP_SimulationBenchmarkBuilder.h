@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldPartition/WorldPartitionBuilder.h"
+#include "TP_SimulationBenchmarkBuilder.generated.h"
+
+/**
+ * Headless throughput benchmark for FTP_SimulationPool: loads a map with no rendering, runs parallel parkour simulations
+ * against its collision with random inputs and logs simulated seconds per wall-clock second (total and per core).
+ * Nothing is saved.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd ThirdYearProject.uproject /Game/FirstPerson/Maps/FirstPersonMap -run=WorldPartitionBuilderCommandlet
+ *     -Builder=TP_SimulationBenchmarkBuilder [-Environments=256] [-Characters=4] [-Seconds=60] -AllowCommandletRendering=false -unattended
+ */
+UCLASS()
+class UTP_SimulationBenchmarkBuilder : public UWorldPartitionBuilder
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	// UWorldPartitionBuilder interface begin
+	virtual bool RequiresCommandletRendering() const override { return false; }
+	virtual ELoadingMode GetLoadingMode() const override { return ELoadingMode::EntireWorld; }
+
+protected:
+	virtual bool RunInternal(UWorld* World, const FCellInfo& InCellInfo, FPackageSourceControlHelper& PackageHelper) override;
+	// UWorldPartitionBuilder interface end
+
+private:
+	/** Independent simulations stepped in parallel */
+	int32 NumEnvironments;
+
+	/** Characters in each simulation */
+	int32 NumCharacters;
+
+	/** Simulated time per environment */
+	float Seconds;
+};